@@ -0,0 +1,137 @@
+// compares DataSet::writeRows/readRows with a loop of one-row
+// selections, the way rows were moved before
+//
+//  iris-bench-rows [file.h5] [rows] [samples] [chunk rows]
+
+#include <h5x/File.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+typedef std::chrono::steady_clock bench_clock;
+
+// best of a few runs, in ms
+template<typename Fn>
+static double time_it(Fn fn, int runs = 5) {
+    double best = -1.0;
+
+    for (int i = 0; i < runs; i++) {
+        auto t0 = bench_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(bench_clock::now() - t0).count();
+        best = best < 0 ? ms : std::min(best, ms);
+    }
+
+    return best;
+}
+
+static h5x::Selection row_selection(const h5x::DataSet &ds, h5x::ndsize_t row, h5x::ndsize_t width,
+                                    h5x::NDSize &count) {
+    count = h5x::NDSize(2, 1);
+    count[1] = width;
+
+    h5x::NDSize offset(2, 0);
+    offset[0] = row;
+
+    h5x::Selection sel = ds.createSelection();
+    sel.select(count, offset);
+    return sel;
+}
+
+static void write_per_row(h5x::DataSet &ds, const std::vector<float> &data, size_t rows, h5x::ndsize_t width) {
+    for (size_t i = 0; i < rows; i++) {
+        h5x::NDSize count;
+        h5x::Selection fsel = row_selection(ds, i, width, count);
+        h5x::Selection msel(h5x::DataSpace::create(count, false));
+        ds.write(h5x::TypeId::Float, data.data() + i * width, fsel, msel);
+    }
+}
+
+static void read_per_row(const h5x::DataSet &ds, std::vector<float> &out,
+                         const std::vector<h5x::ndsize_t> &rows, h5x::ndsize_t width) {
+    for (size_t k = 0; k < rows.size(); k++) {
+        h5x::NDSize count;
+        h5x::Selection fsel = row_selection(ds, rows[k], width, count);
+        h5x::Selection msel(h5x::DataSpace::create(count, false));
+        ds.read(h5x::TypeId::Float, out.data() + k * width, fsel, msel);
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::string path = argc > 1 ? argv[1] : "bench-rows.h5";
+    const size_t rows = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    const h5x::ndsize_t width = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 101;
+    const h5x::ndsize_t chunk = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 64;
+
+    if (rows == 0 || width == 0 || chunk == 0) {
+        std::cerr << "usage: " << argv[0] << " [file.h5] [rows] [samples] [chunk rows]" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<float> data(rows * width);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<float>(i);
+        }
+
+        h5x::File fd = h5x::File::open(path, "w");
+
+        h5x::NDSize shape(2, 0);
+        shape[0] = rows;
+        shape[1] = width;
+
+        h5x::DataSetOptions opts;
+        opts.chunks = h5x::NDSize(2, 0);
+        opts.chunks[0] = std::min<h5x::ndsize_t>(chunk, rows);
+        opts.chunks[1] = width;
+
+        h5x::DataSet loop = fd.createData("loop", h5x::TypeId::Float, shape, opts);
+        h5x::DataSet block = fd.createData("block", h5x::TypeId::Float, shape, opts);
+
+        double w_loop = time_it([&] { write_per_row(loop, data, rows, width); });
+        double w_block = time_it([&] { block.writeRows(h5x::TypeId::Float, data.data(), 0, rows); });
+
+        std::vector<h5x::ndsize_t> every3;
+        for (size_t i = 0; i < rows; i += 3) {
+            every3.push_back(i);
+        }
+
+        std::vector<h5x::ndsize_t> shuffled(every3.rbegin(), every3.rend());
+
+        std::vector<float> a(every3.size() * width);
+        std::vector<float> b(every3.size() * width);
+
+        double r_loop = time_it([&] { read_per_row(loop, a, every3, width); });
+        double r_block = time_it([&] { block.readRows(h5x::TypeId::Float, b.data(), every3); });
+
+        if (a != b) {
+            std::cerr << "[E] readRows differs from the per-row loop" << std::endl;
+            return 1;
+        }
+
+        double r_loop_rev = time_it([&] { read_per_row(loop, a, shuffled, width); });
+        double r_block_rev = time_it([&] { block.readRows(h5x::TypeId::Float, b.data(), shuffled); });
+
+        if (a != b) {
+            std::cerr << "[E] readRows (reversed) differs from the per-row loop" << std::endl;
+            return 1;
+        }
+
+        std::cout << rows << " rows x " << width << " floats, chunks of " << opts.chunks[0] << " rows" << std::endl;
+        std::cout << "  write all rows:           " << w_loop << " ms per-row, " << w_block << " ms writeRows" << std::endl;
+        std::cout << "  read every 3rd row:       " << r_loop << " ms per-row, " << r_block << " ms readRows" << std::endl;
+        std::cout << "  read every 3rd, reversed: " << r_loop_rev << " ms per-row, " << r_block_rev << " ms readRows" << std::endl;
+
+        fd.close();
+
+    } catch (const std::exception &e) {
+        std::cerr << "[E] " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,8 +1,19 @@
 #include <data.h>
+#include <pack.h>
+#include <record.h>
+#include <stored.h>
+#include <watch.h>
 #include <yaml-cpp/yaml.h>
 #include <csv.h>
 #include <misc.h>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+
 #define CUR_VERSION "1.0"
 
 namespace iris {
@@ -29,7 +40,102 @@ static fs::file find_default_location() {
 }
 
 
-iris::data::store iris::data::store::default_store() {
+// cache files are rewritten whenever they are found to be stale and
+// failing to write them (e.g. read-only store) is not an error; the
+// first failure is reported and no further writes are tried for that
+// store. They are not synced, a torn file is detected and rebuilt.
+static void write_cache_file(const fs::file &base, fs::file path, const std::string &data) {
+    static std::mutex lock;
+    static std::set<std::string> readonly;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (readonly.count(base.path()) > 0) {
+            return;
+        }
+    }
+
+    try {
+        fs::file dir = path.parent();
+        if (!dir.exists()) {
+            dir.mkdir_with_parents();
+        }
+        path.write_all(data, true, false);
+    } catch (const std::exception &e) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (readonly.insert(base.path()).second) {
+            std::cerr << "[W] not caching for store " << base.path() << ": could not write ";
+            std::cerr << path.path() << " (" << e.what() << ")" << std::endl;
+        }
+    }
+}
+
+// a change within the same mtime tick would go unnoticed if the
+// directory was modified just now, so such a mtime is not trusted
+static bool mtime_is_racy(int64_t mtime) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    return now_ns - mtime < 2000000000LL;
+}
+
+// parsed records are cached as binary records (see record.h) in
+// cache/records/<path>.rec, keyed on the size and mtime of the YAML;
+// a store snapshot (pack.h) holding an up to date record comes first
+template<typename T>
+static T load_record(const fs::file &base, const store_pack *pack,
+                     const std::string &path, T (*from_yaml)(const std::string &)) {
+    fs::file src = base.child(path);
+    fs::file rec = base.child("cache/records/" + path + ".rec");
+
+    fs::file::status st = src.stat();
+
+    const store_pack::entry *e = pack != nullptr ? pack->find(path) : nullptr;
+    if (e != nullptr && e->kind == pack_kind::record && e->st.size == st.size && e->st.mtime == st.mtime) {
+        try {
+            T obj;
+            decode_record(record_reader(e->data, e->length), obj);
+            return obj;
+        } catch (const wire_error &ex) {
+            std::cerr << "[W] ignoring broken record in pack: " << path << std::endl;
+        }
+    }
+
+    if (rec.exists()) {
+        try {
+            record_reader reader(rec.read_all());
+            const fs::file::status &rs = reader.source();
+
+            if (rs.size == st.size && rs.mtime == st.mtime) {
+                T obj;
+                decode_record(reader, obj);
+                return obj;
+            }
+        } catch (const wire_error &e) {
+            std::cerr << "[W] ignoring broken record: " << rec.path() << std::endl;
+        }
+    }
+
+    T obj = from_yaml(src.read_all());
+
+    if (!mtime_is_racy(st.mtime)) {
+        write_cache_file(base, rec, encode_record(obj, st));
+    }
+
+    return obj;
+}
+
+iris::data::store iris::data::store::default_store(bool use_service) {
+
+    if (use_service) {
+        std::shared_ptr<store_client> client = store_client::connect(store_service_path());
+
+        // the service checked the version when it started
+        if (client && fs::file(client->location()).exists()) {
+            data::store store(fs::file(client->location()));
+            store.service = client;
+            return store;
+        }
+    }
 
     fs::file base = find_default_location();
     fs::file fver = base.child("/version");
@@ -39,6 +145,17 @@ iris::data::store iris::data::store::default_store() {
     }
 
     data::store store(base);
+
+    const char *env = getenv("IRIS_STORE_PACK");
+    if (env != nullptr && env[0] != '\0') {
+        store.packed = store_pack::open(fs::file(env));
+        if (!store.packed) {
+            std::cerr << "[W] could not open store pack: " << env << std::endl;
+        }
+    } else {
+        store.packed = store_pack::open(base.child("cache/store.pack"));
+    }
+
     std::string sver = store.version_string();
 
     if (sver != CUR_VERSION) {
@@ -55,10 +172,24 @@ iris::data::store::store(const fs::file &path) : base(path) {
 }
 
 
-std::string store::version_string() const {
-    fs::file fver = base.child("/version");
+void store::drop_service(const wire_error &e) const {
+    std::cerr << "[W] store service: " << e.what() << "; using the store directly" << std::endl;
+    service.reset();
+}
+
+// the pack has no checksum; if it turns out to be broken, the tree
+// (the source of truth) is used from then on
+void store::drop_snapshot(const wire_error &e) const {
+    std::cerr << "[W] store pack: " << e.what() << "; using the store directly" << std::endl;
+    packed.reset();
+}
 
-    std::string sver = fver.read_all();
+std::unique_ptr<store_watcher> store::watch() {
+    return std::unique_ptr<store_watcher>(new store_watcher(*this));
+}
+
+std::string store::version_string() const {
+    std::string sver = read_file("version");
     sver.erase(std::find_if(sver.begin(), sver.end(), [](const char c) {
         return c == ' ' || c == '\n' || c == '\t';
     }));
@@ -68,6 +199,22 @@ std::string store::version_string() const {
 
 std::string iris::data::store::default_monitor() const {
 
+    if (service) {
+        try {
+            return service->default_monitor();
+        } catch (const wire_error &e) {
+            drop_service(e);
+        }
+    }
+
+    // the link can only be replaced, which changes the store dir
+    const store_pack::entry *e = packed ? packed->find("default.monitor") : nullptr;
+    const store_pack::entry *d = packed ? packed->find("") : nullptr;
+
+    if (e != nullptr && e->kind == pack_kind::link && d != nullptr && d->st.mtime == base.stat().mtime) {
+        return fs::file(e->content()).name();
+    }
+
     fs::file dm_link = base.child("default.monitor");
 
     if (!dm_link.exists()) {
@@ -80,25 +227,28 @@ std::string iris::data::store::default_monitor() const {
 
 
 std::vector<std::string> store::list_monitors() const {
-    fs::file mdir = base.child("monitors");
+    std::vector<std::string> names;
 
-    std::vector<fs::file> res;
-    std::copy_if(mdir.children().begin(), mdir.children().end(), std::back_inserter(res), [](const fs::file &f){
-        fs::file mfile = f.child("/" + f.name() + ".monitor");
-        return mfile.exists();
-    });
-
-    std::vector<std::string> names(res.size());
-    std::transform(res.begin(), res.end(), names.begin(), [](const fs::file &f){
-        return f.name();
-    });
+    for (const std::string &id : list_dir("monitors")) {
+        if (!list_dir("monitors/" + id, fs::fn_matcher(id + ".monitor")).empty()) {
+            names.push_back(id);
+        }
+    }
 
     return names;
 }
 
 iris::data::monitor iris::data::store::load_monitor(const std::string &uid) const {
-    fs::file mfs = base.child("monitors/" + uid + "/" + uid + ".monitor");
-    return yaml2monitor(mfs.read_all());
+
+    if (service) {
+        try {
+            return service->load_monitor(uid);
+        } catch (const wire_error &e) {
+            drop_service(e);
+        }
+    }
+
+    return load_record(base, packed.get(), "monitors/" + uid + "/" + uid + ".monitor", &yaml2monitor);
 }
 
 
@@ -113,19 +263,12 @@ std::string store::latest_settings(const monitor &monitor) const {
 
 std::vector<std::string> store::list_settings(const monitor &monitor) const {
 
-    fs::file mdir = base.child("monitors/" + monitor.qualified_id());
-
-    std::vector<fs::file> res;
-    std::copy_if(mdir.children().begin(), mdir.children().end(),
-                 std::back_inserter(res), fs::fn_matcher("*.settings"));
-
-    std::sort(res.begin(), res.end(), [](const fs::file &a, const fs::file &b) {
-        return a.name() > b.name();
-    });
+    std::vector<std::string> res = list_dir("monitors/" + monitor.qualified_id(),
+                                            fs::fn_matcher("*.settings"),
+                                            fs::scan_order::descending);
 
     std::vector<std::string> ids;
-    std::transform(res.begin(), res.end(), std::back_inserter(ids), [](const fs::file &f) {
-        std::string name = f.name();
+    std::transform(res.begin(), res.end(), std::back_inserter(ids), [](std::string name) {
         size_t len = name.size();
         name.erase(len - 9, 9); // we matched for "*.settings"
         return name;
@@ -134,32 +277,379 @@ std::vector<std::string> store::list_settings(const monitor &monitor) const {
     return ids;
 }
 
-rgb2lms store::load_rgb2lms(const display &display) const {
+static std::vector<std::string> split_tabs(const std::string &line) {
+    std::vector<std::string> fields;
+    std::string::size_type start = 0;
 
-    // need to find the latest calibration that fits the display
+    for (;;) {
+        std::string::size_type pos = line.find('\t', start);
+        fields.push_back(line.substr(start, pos - start));
 
-    fs::file mdir = base.child("monitors/" + display.monitor_id);
+        if (pos == std::string::npos) {
+            break;
+        }
+
+        start = pos + 1;
+    }
+
+    return fields;
+}
+
+// store journal
+//  writes to the store append a line to <store>/journal:
+//    <op> <path> <size> <mtime> <dir-mtime>
+//  (tab separated, mtimes in ns, path relative to the store). The
+//  indexes remember how far they have read and apply newer entries
+//  instead of rescanning, as long as nothing changed the directory
+//  behind the journal's back (i.e. its mtime is the journaled one).
+
+static void append_journal(const fs::file &base, const journal_entry &e) {
+    std::stringstream line;
+    line << e.op << "\t" << e.path << "\t" << e.st.size << "\t" << e.st.mtime;
+    line << "\t" << e.dir_mtime << "\n";
+
+    // O_APPEND is not atomic on NFS
+    fs::file_lock lock(base.child(".journal.lock"));
+
+    std::ofstream out(base.child("journal").path(), std::ios::app | std::ios::binary);
+    out << line.str();
+    out.close();
+
+    if (!out.good()) {
+        std::cerr << "[W] could not write to the store journal" << std::endl;
+    }
+}
+
+bool store::read_journal(uint64_t &offset, std::vector<journal_entry> &entries) const {
+    std::ifstream in(base.child("journal").path(), std::ios::binary);
+
+    if (!in.is_open()) {
+        bool same = offset == 0;
+        offset = 0;
+        return same;
+    }
+
+    in.seekg(0, std::ios::end);
+    const uint64_t size = static_cast<uint64_t>(in.tellg());
+
+    if (size < offset) {
+        offset = size;
+        return false;
+    }
+
+    std::string data(size - offset, '\0');
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(&data[0], static_cast<std::streamsize>(data.size()));
 
-    std::vector<fs::file> res;
-    std::copy_if(mdir.children().begin(), mdir.children().end(),
-              std::back_inserter(res), fs::fn_matcher("*.rgb2lms"));
+    size_t pos = 0;
+    for (size_t nl = data.find('\n'); nl != std::string::npos; nl = data.find('\n', pos)) {
+        std::vector<std::string> f = split_tabs(data.substr(pos, nl - pos));
+        pos = nl + 1;
 
-    std::sort(res.begin(), res.end(), [](const fs::file &a, const fs::file &b) {
-        return a.name() > b.name();
+        if (f.size() != 5) {
+            continue;
+        }
+
+        journal_entry e;
+        e.op = f[0];
+        e.path = f[1];
+        e.st.size = std::stoull(f[2]);
+        e.st.mtime = std::stoll(f[3]);
+        e.dir_mtime = std::stoll(f[4]);
+        entries.push_back(e);
+    }
+
+    // a partial last line is being written right now
+    offset += pos;
+    return true;
+}
+
+// rgb2lms index
+//  maps the display of every *.rgb2lms file in a monitor directory to
+//  the file, so lookups do not have to parse all calibrations. It lives
+//  in cache/rgb2lms/__ID__.index (outside the monitor dir, so updating it
+//  does not change the mtime of the latter) and is validated by the mtime
+//  of the monitor dir and the size and mtime of each file.
+
+struct rgb2lms_entry {
+    std::string     name;
+    fs::file::status st;
+    display         dsy;
+};
+
+typedef std::vector<rgb2lms_entry> rgb2lms_index;
+
+static bool display_matches(const display &a, const display &b) {
+    //FIXME:: check mode too
+    return a.monitor_id  == b.monitor_id &&
+           a.settings_id == b.settings_id &&
+           a.link_id     == b.link_id &&
+           a.gfx         == b.gfx;
+}
+
+static fs::file rgb2lms_index_file(const fs::file &base, const std::string &monitor_id) {
+    return base.child("cache/rgb2lms/" + monitor_id + ".index");
+}
+
+// index file format (tab separated, one calibration per line):
+//   rgb2lms-index <version>
+//   dir-mtime <ns>
+//   journal <offset>
+//   <file> <size> <mtime> <monitor> <settings> <link> <gfx> <w> <h> <refresh> <r> <g> <b>
+// a flat format instead of yaml, since parsing it has to be cheap
+
+#define RGB2LMS_INDEX_VERSION "2"
+
+static bool read_rgb2lms_index(const fs::file &path, int64_t &dir_mtime, uint64_t &journal, rgb2lms_index &index) {
+    if (!path.exists()) {
+        return false;
+    }
+
+    try {
+        std::stringstream in(path.read_all());
+        std::string line;
+
+        std::getline(in, line);
+        if (line != "rgb2lms-index\t" RGB2LMS_INDEX_VERSION) {
+            return false;
+        }
+
+        std::getline(in, line);
+        std::vector<std::string> header = split_tabs(line);
+        if (header.size() != 2 || header[0] != "dir-mtime") {
+            return false;
+        }
+
+        dir_mtime = std::stoll(header[1]);
+
+        std::getline(in, line);
+        header = split_tabs(line);
+        if (header.size() != 2 || header[0] != "journal") {
+            return false;
+        }
+
+        journal = std::stoull(header[1]);
+
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+
+            std::vector<std::string> f = split_tabs(line);
+            if (f.size() != 13) {
+                throw std::runtime_error("invalid index entry");
+            }
+
+            rgb2lms_entry e;
+            e.name = f[0];
+            e.st.size = std::stoull(f[1]);
+            e.st.mtime = std::stoll(f[2]);
+            e.dsy.monitor_id = f[3];
+            e.dsy.settings_id = f[4];
+            e.dsy.link_id = f[5];
+            e.dsy.gfx = f[6];
+            e.dsy.mode.width = std::stof(f[7]);
+            e.dsy.mode.height = std::stof(f[8]);
+            e.dsy.mode.refresh = std::stof(f[9]);
+            e.dsy.mode.r = std::stoi(f[10]);
+            e.dsy.mode.g = std::stoi(f[11]);
+            e.dsy.mode.b = std::stoi(f[12]);
+
+            index.push_back(e);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "[W] ignoring broken rgb2lms index: " << path.path() << std::endl;
+        index.clear();
+        return false;
+    }
+
+    return true;
+}
+
+static void write_rgb2lms_index(const fs::file &base, fs::file path, int64_t dir_mtime, uint64_t journal, const rgb2lms_index &index) {
+    std::stringstream out;
+
+    out << "rgb2lms-index\t" RGB2LMS_INDEX_VERSION << std::endl;
+    out << "dir-mtime\t" << dir_mtime << std::endl;
+    out << "journal\t" << journal << std::endl;
+
+    for (const rgb2lms_entry &e : index) {
+        const display &d = e.dsy;
+        out << e.name << "\t" << e.st.size << "\t" << e.st.mtime << "\t";
+        out << d.monitor_id << "\t" << d.settings_id << "\t" << d.link_id << "\t" << d.gfx << "\t";
+        out << d.mode.width << "\t" << d.mode.height << "\t" << d.mode.refresh << "\t";
+        out << d.mode.r << "\t" << d.mode.g << "\t" << d.mode.b << std::endl;
+    }
+
+    write_cache_file(base, path, out.str());
+}
+
+static void sort_rgb2lms_index(rgb2lms_index &index) {
+    std::sort(index.begin(), index.end(), [](const rgb2lms_entry &a, const rgb2lms_entry &b) {
+        return a.name > b.name;
     });
+}
 
-    for (const fs::file f : res) {
-        std::string data = f.read_all();
-        rgb2lms ca = yaml2rgb2lms(data);
+// add the calibrations journaled for this monitor to the index; false
+// if the directory was changed in ways the journal does not account for
+static bool apply_rgb2lms_journal(const fs::file &base,
+                                  const std::string &monitor_id,
+                                  int64_t dir_mtime,
+                                  const std::vector<journal_entry> &journal,
+                                  rgb2lms_index &index) {
+    const std::string prefix = "monitors/" + monitor_id + "/";
+
+    int64_t journaled_mtime = -1;
+    for (const journal_entry &j : journal) {
+        if (j.path.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+
+        const std::string name = j.path.substr(prefix.size());
+        if (j.op != "add" || name.find('/') != std::string::npos) {
+            return false;
+        }
 
-        const struct display &d = ca.dsy;
+        journaled_mtime = j.dir_mtime;
+
+        if (!fs::fn_matcher("*.rgb2lms")(name)) {
+            continue;
+        }
+
+        fs::file f = base.child(j.path);
+        if (!f.exists()) {
+            return false;
+        }
+
+        fs::file::status st = f.stat();
+        if (st.size != j.st.size || st.mtime != j.st.mtime) {
+            return false;
+        }
+
+        rgb2lms_entry e;
+        e.name = name;
+        e.st = st;
+
+        try {
+            e.dsy = load_record(base, nullptr, j.path, &store::yaml2rgb2lms).dsy;
+        } catch (const std::exception &ex) {
+            return false;
+        }
+
+        index.erase(std::remove_if(index.begin(), index.end(), [&name](const rgb2lms_entry &o) {
+            return o.name == name;
+        }), index.end());
+
+        index.push_back(e);
+    }
 
-        if (d.monitor_id  == display.monitor_id &&
-            d.settings_id == display.settings_id &&
-            d.link_id     == display.link_id &&
-            d.gfx         == display.gfx) {
+    if (journaled_mtime != dir_mtime) {
+        return false;
+    }
+
+    sort_rgb2lms_index(index);
+    return true;
+}
+
+// bring the index up to date; calibrations added via the journal are
+// applied directly, otherwise only files that are new or changed since
+// the index was written are parsed. Sorted, newest first.
+static rgb2lms_index update_rgb2lms_index(const store &st, const std::string &monitor_id, bool force) {
+    fs::file base = st.location();
+    fs::file mdir = base.child("monitors/" + monitor_id);
+    fs::file ipath = rgb2lms_index_file(base, monitor_id);
+
+    const int64_t dir_mtime = mdir.stat().mtime;
+
+    int64_t idx_mtime = -1;
+    uint64_t journal_pos = 0;
+    rgb2lms_index old;
+    bool have_index = read_rgb2lms_index(ipath, idx_mtime, journal_pos, old);
+
+    if (have_index && !force && idx_mtime == dir_mtime) {
+        return old;
+    }
+
+    // the journal position has to be taken before a rescan,
+    // writes that happen during the scan are then applied again
+    std::vector<journal_entry> journal;
+    bool journal_ok = st.read_journal(journal_pos, journal);
+
+    if (have_index && !force && journal_ok) {
+        rgb2lms_index index = old;
+        if (apply_rgb2lms_journal(base, monitor_id, dir_mtime, journal, index)) {
+            write_rgb2lms_index(base, ipath, mtime_is_racy(dir_mtime) ? -1 : dir_mtime, journal_pos, index);
+            return index;
+        }
+    }
+
+    rgb2lms_index index;
+    for (const fs::dir_entry &de : fs::scan(mdir, fs::fn_matcher("*.rgb2lms"))) {
+        fs::file f = mdir.child(de.name);
+
+        rgb2lms_entry e;
+        e.name = de.name;
+        e.st = f.stat();
+
+        auto known = std::find_if(old.cbegin(), old.cend(), [&e](const rgb2lms_entry &o) {
+            return o.name == e.name && o.st.size == e.st.size && o.st.mtime == e.st.mtime;
+        });
+
+        if (known != old.cend()) {
+            e.dsy = known->dsy;
+        } else {
+            try {
+                e.dsy = store::yaml2rgb2lms(f.read_all()).dsy;
+            } catch (const std::exception &ex) {
+                std::cerr << "[W] skipping unreadable rgb2lms: " << f.path() << std::endl;
+                continue;
+            }
+        }
+
+        index.push_back(e);
+    }
+
+    sort_rgb2lms_index(index);
+
+    write_rgb2lms_index(base, ipath, mtime_is_racy(dir_mtime) ? -1 : dir_mtime, journal_pos, index);
+    return index;
+}
+
+rgb2lms store::load_rgb2lms(const display &display) const {
+
+    if (service) {
+        try {
+            return service->load_rgb2lms(display);
+        } catch (const wire_error &e) {
+            drop_service(e);
+        }
+    }
+
+    // need to find the latest calibration that fits the display
+    for (int pass = 0; pass < 2; pass++) {
+        rgb2lms_index index = update_rgb2lms_index(*this, display.monitor_id, pass > 0);
 
-            //FIXME:: check mode too
+        auto hit = std::find_if(index.cbegin(), index.cend(), [&display](const rgb2lms_entry &e) {
+            return display_matches(e.dsy, display);
+        });
+
+        if (hit == index.cend()) {
+            continue;
+        }
+
+        // files edited in place do not change the directory mtime
+        fs::file f = base.child("monitors/" + display.monitor_id + "/" + hit->name);
+        if (!f.exists()) {
+            continue;
+        }
+
+        fs::file::status st = f.stat();
+        if (st.size != hit->st.size || st.mtime != hit->st.mtime) {
+            continue;
+        }
+
+        rgb2lms ca = load_record(base, packed.get(), "monitors/" + display.monitor_id + "/" + hit->name, &yaml2rgb2lms);
+        if (display_matches(ca.dsy, display)) {
             return ca;
         }
     }
@@ -180,85 +670,494 @@ fs::file store::store_rgb2lms(const rgb2lms &rgb2lms) {
         throw std::runtime_error("Could not import rgb2lms; monitor loading error");
     }
 
+    const std::string path = "monitors/" + display.monitor_id + "/" + rgb2lms.identifier() + ".rgb2lms";
     fs::file mdir = base.child("monitors/" + display.monitor_id);
-    fs::file fd = mdir.child(rgb2lms.identifier() + ".rgb2lms");
+    fs::file fd = base.child(path);
 
     if (fd.exists()) {
         throw std::runtime_error("rgb2lms data already exists!");
     }
 
     std::string data = rgb2lms2yaml(rgb2lms);
-    fd.write_all(data);
+
+    {
+        // several rigs might share the (network) store; the journal
+        // entry has to record the directory state right after our write
+        fs::file_lock lock(mdir.child(".lock"));
+
+        try {
+            fd.write_all(data, false);
+        } catch (const std::runtime_error &e) {
+            throw std::runtime_error(fd.exists() ? "rgb2lms data already exists!" : e.what());
+        }
+
+        append_journal(base, journal_entry{"add", path, fd.stat(), mdir.stat().mtime});
+    }
+
+    update_rgb2lms_index(*this, display.monitor_id, false);
 
     return fd;
 }
 
+// content index
+//  hashes of the data files in the monitor directories, persisted in
+//  cache/content.index (tab separated):
+//    content-index <version>
+//    <path> <size> <mtime> <hash>
+//  an entry is valid while size and mtime match; files are only
+//  hashed when their size matches a file being imported, and a hash
+//  match is confirmed byte by byte before a file is shared.
+
+#define CONTENT_INDEX_VERSION "1"
+
+struct content_entry {
+    fs::file::status st;
+    uint64_t hash;
+};
+
+typedef std::map<std::string, content_entry> content_index;
+
+static content_index read_content_index(const fs::file &path) {
+    content_index index;
+
+    if (!path.exists()) {
+        return index;
+    }
+
+    try {
+        std::stringstream in(path.read_all());
+        std::string line;
+
+        std::getline(in, line);
+        if (line != "content-index\t" CONTENT_INDEX_VERSION) {
+            return index;
+        }
+
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+
+            std::vector<std::string> f = split_tabs(line);
+            if (f.size() != 4) {
+                throw std::runtime_error("invalid index entry");
+            }
+
+            content_entry e;
+            e.st.size = std::stoull(f[1]);
+            e.st.mtime = std::stoll(f[2]);
+            e.hash = std::stoull(f[3], nullptr, 16);
+
+            index[f[0]] = e;
+        }
+
+    } catch (const std::exception &e) {
+        std::cerr << "[W] ignoring broken content index: " << path.path() << std::endl;
+        index.clear();
+    }
+
+    return index;
+}
+
+static void write_content_index(const fs::file &base, const fs::file &path, const content_index &index) {
+    std::stringstream out;
+    out << "content-index\t" CONTENT_INDEX_VERSION << std::endl;
+
+    for (const auto &kv : index) {
+        out << kv.first << "\t" << kv.second.st.size << "\t" << kv.second.st.mtime << "\t";
+        out << std::hex << kv.second.hash << std::dec << std::endl;
+    }
+
+    write_cache_file(base, path, out.str());
+}
+
+static bool same_content(const fs::file &a, const fs::file &b) {
+    std::ifstream fa(a.path(), std::ios::in | std::ios::binary);
+    std::ifstream fb(b.path(), std::ios::in | std::ios::binary);
+
+    std::vector<char> ba(1024 * 1024);
+    std::vector<char> bb(ba.size());
+
+    while (fa.good() && fb.good()) {
+        fa.read(ba.data(), ba.size());
+        fb.read(bb.data(), bb.size());
+
+        if (fa.gcount() != fb.gcount() ||
+            memcmp(ba.data(), bb.data(), static_cast<size_t>(fa.gcount())) != 0) {
+            return false;
+        }
+    }
+
+    return fa.eof() && fb.eof();
+}
+
+fs::copy_mode store::import_file(const fs::file &src, const std::string &path) {
+    fs::file dest = base.child(path);
+    fs::file ipath = base.child("cache/content.index");
+
+    if (dest.exists()) {
+        throw std::runtime_error("File exists: " + dest.path());
+    }
+
+    const fs::file::status sst = src.stat();
+
+    content_index known = read_content_index(ipath);
+    content_index index;
+
+    uint64_t hash = 0;
+    bool hashed = false;
+    fs::file twin;
+
+    fs::file monitors = base.child("monitors");
+
+    for (const fs::dir_entry &me : fs::scan(monitors)) {
+        const std::string &mid = me.name;
+        if (!me.is_directory(monitors)) {
+            continue;
+        }
+
+        fs::file mdir = monitors.child(mid);
+
+        for (const fs::dir_entry &fe : fs::scan(mdir)) {
+            const std::string &n = fe.name;
+            if (n[0] == '.' || fe.is_directory(mdir)) {
+                continue;
+            }
+
+            fs::file f = mdir.child(n);
+            const std::string rel = "monitors/" + mid + "/" + n;
+            const fs::file::status st = f.stat();
+
+            auto k = known.find(rel);
+            if (k != known.end() && k->second.st.size == st.size && k->second.st.mtime == st.mtime) {
+                index[rel] = k->second;
+            }
+
+            if (st.size != sst.size || !twin.path().empty()) {
+                continue;
+            }
+
+            if (!hashed) {
+                hash = src.content_hash();
+                hashed = true;
+            }
+
+            if (index.find(rel) == index.end()) {
+                index[rel] = content_entry{st, f.content_hash()};
+            }
+
+            if (index[rel].hash == hash && same_content(src, f)) {
+                twin = f;
+            }
+        }
+    }
+
+    fs::copy_mode how;
+    if (!twin.path().empty()) {
+        how = twin.copy(dest, false, fs::copy_mode::link);
+    } else {
+        how = src.copy(dest, false, fs::copy_mode::clone);
+    }
+
+    // without a file of the same size we did not need the hash,
+    // it is computed once another file of that size shows up
+    if (hashed) {
+        index[path] = content_entry{dest.stat(), hash};
+    }
+
+    write_content_index(base, ipath, index);
+    return how;
+}
+
 subject store::load_subject(const std::string &uid) {
-    fs::file sfile = base.child("subjects/" + uid + "/" + uid + ".subject");
-    return yaml2subject(sfile.read_all());
+    return load_record(base, packed.get(), "subjects/" + uid + "/" + uid + ".subject", &yaml2subject);
 }
 
 
-std::vector<iris::data::subject> store::find_subjects(const std::string &phrase) {
-    fs::file sdir = base.child("subjects");
+// subject index
 
-    std::vector<fs::file> res;
-    std::copy_if(sdir.children().begin(), sdir.children().end(),
-                 std::back_inserter(res),
-                 [](const fs::file &f) {
-                     const std::string &n = f.name();
-                     if (n == "." || n == ".." || ! f.is_directory()) {
-                         return false;
-                     }
-
-                     fs::file sf = f.child(n + ".subject");
-                     return sf.exists();
-                 });
-
-    std::vector<subject> subjects;
-    std::transform(res.cbegin(), res.cend(), std::back_inserter(subjects),
-                   [this](const fs::file &f) {
-                       return load_subject(f.name());
-                   });
-
-    std::vector<subject> hits;
-    std::copy_if(subjects.cbegin(), subjects.cend(), std::back_inserter(hits),
-                 [&phrase](const subject &s) {
-                     return s.name == phrase ||
-                            s.initials == phrase ||
-                            s.identifier() == phrase ||
-                            s.qualified_id() == phrase;
-                 });
-
-    return hits;
+static std::string to_lower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return str;
 }
 
-isoslant store::load_isoslant(const subject &subject) {
-    fs::file sdir = base.child("subjects/" + subject.identifier());
+void subject_index::insert(const subject &s) {
+    const size_t idx = subjects.size();
+    subjects.push_back(s);
 
-    std::vector<fs::file> res;
-    std::copy_if(sdir.children().begin(), sdir.children().end(),
-                 std::back_inserter(res), fs::fn_matcher("*.isoslant"));
+    keys.emplace(to_lower(s.identifier()), idx);
+    keys.emplace(to_lower(s.initials), idx);
+    keys.emplace(to_lower(s.name), idx);
 
-    std::sort(res.begin(), res.end(), [](const fs::file &a, const fs::file &b) {
-        return a.name() > b.name();
+    names.emplace_back(to_lower(s.name), idx);
+    names_sorted = false;
+}
+
+void subject_index::clear() {
+    subjects.clear();
+    keys.clear();
+    names.clear();
+    names_sorted = true;
+}
+
+std::vector<subject> subject_index::find(const std::string &phrase, int how) const {
+    const bool icase = (how & ignore_case) != 0;
+    const std::string needle = to_lower(phrase);
+
+    std::vector<size_t> hits;
+
+    auto range = keys.equal_range(needle);
+    for (auto it = range.first; it != range.second; ++it) {
+        const subject &s = subjects[it->second];
+        if (icase || s.name == phrase || s.initials == phrase ||
+            s.identifier() == phrase || s.qualified_id() == phrase) {
+            hits.push_back(it->second);
+        }
+    }
+
+    if (how & prefix) {
+        if (!names_sorted) {
+            std::sort(names.begin(), names.end());
+            names_sorted = true;
+        }
+
+        auto it = std::lower_bound(names.cbegin(), names.cend(), std::make_pair(needle, size_t(0)));
+        for (; it != names.cend() && it->first.compare(0, needle.size(), needle) == 0; ++it) {
+            const subject &s = subjects[it->second];
+            if (icase || s.name.compare(0, phrase.size(), phrase) == 0) {
+                hits.push_back(it->second);
+            }
+        }
+    }
+
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    std::vector<subject> res;
+    std::transform(hits.cbegin(), hits.cend(), std::back_inserter(res), [this](size_t i) {
+        return subjects[i];
     });
 
+    return res;
+}
+
+// subject cache
+//  the parsed subjects of the store, persisted in cache/subjects.index
+//  (tab separated, same scheme as the rgb2lms index):
+//    subject-index <version>
+//    dir-mtime <ns>
+//    <id> <size> <mtime> <initials> <name>
+//  trusted while the mtime of subjects/ is unchanged; subjects found by
+//  a query are re-validated by the size and mtime of their file.
+
+#define SUBJECT_INDEX_VERSION "1"
+
+struct subject_cache {
+    int64_t dir_mtime = -1;
+    std::map<std::string, fs::file::status> files;
+    subject_index index;
+};
+
+static bool read_subject_cache(const fs::file &path, subject_cache &cache) {
+    if (!path.exists()) {
+        return false;
+    }
+
+    try {
+        std::stringstream in(path.read_all());
+        std::string line;
+
+        std::getline(in, line);
+        if (line != "subject-index\t" SUBJECT_INDEX_VERSION) {
+            return false;
+        }
+
+        std::getline(in, line);
+        std::vector<std::string> header = split_tabs(line);
+        if (header.size() != 2 || header[0] != "dir-mtime") {
+            return false;
+        }
+
+        cache.dir_mtime = std::stoll(header[1]);
+
+        while (std::getline(in, line)) {
+            if (line.empty()) {
+                continue;
+            }
+
+            std::vector<std::string> f = split_tabs(line);
+            if (f.size() != 5) {
+                throw std::runtime_error("invalid index entry");
+            }
+
+            subject s(f[0]);
+            s.initials = f[3];
+            s.name = f[4];
+
+            fs::file::status st;
+            st.size = std::stoull(f[1]);
+            st.mtime = std::stoll(f[2]);
+
+            cache.files[s.identifier()] = st;
+            cache.index.insert(s);
+        }
+
+    } catch (const std::exception &e) {
+        std::cerr << "[W] ignoring broken subject index: " << path.path() << std::endl;
+        cache = subject_cache();
+        return false;
+    }
+
+    return true;
+}
+
+static void write_subject_cache(const fs::file &base, const fs::file &path, const subject_cache &cache) {
+    std::stringstream out;
+
+    out << "subject-index\t" SUBJECT_INDEX_VERSION << std::endl;
+    out << "dir-mtime\t" << (mtime_is_racy(cache.dir_mtime) ? -1 : cache.dir_mtime) << std::endl;
+
+    for (const subject &s : cache.index.all()) {
+        const fs::file::status &st = cache.files.at(s.identifier());
+        out << s.identifier() << "\t" << st.size << "\t" << st.mtime << "\t";
+        out << s.initials << "\t" << s.name << std::endl;
+    }
+
+    write_cache_file(base, path, out.str());
+}
+
+void store::update_subject_cache(bool force) {
+    fs::file sdir = base.child("subjects");
+    fs::file ipath = base.child("cache/subjects.index");
+
+    if (!sdir.exists()) {
+        subjects = std::make_shared<subject_cache>();
+        return;
+    }
+
+    const int64_t dir_mtime = sdir.stat().mtime;
+
+    if (!subjects) {
+        subjects = std::make_shared<subject_cache>();
+        read_subject_cache(ipath, *subjects);
+    }
+
+    if (!force && subjects->dir_mtime == dir_mtime) {
+        return;
+    }
+
+    std::shared_ptr<subject_cache> old = subjects;
+    std::shared_ptr<subject_cache> cache = std::make_shared<subject_cache>();
+    cache->dir_mtime = dir_mtime;
+
+    for (const fs::dir_entry &de : fs::scan(sdir)) {
+        const std::string &n = de.name;
+
+        fs::file sf = sdir.child(n + "/" + n + ".subject");
+        if (!sf.exists()) {
+            continue;
+        }
+
+        fs::file::status st = sf.stat();
+
+        auto known = old->files.find(n);
+        if (known != old->files.end() && known->second.size == st.size && known->second.mtime == st.mtime) {
+            std::vector<subject> hit = old->index.find(n);
+            auto s = std::find_if(hit.cbegin(), hit.cend(), [&n](const subject &s) {
+                return s.identifier() == n;
+            });
+
+            if (s != hit.cend()) {
+                cache->files[n] = st;
+                cache->index.insert(*s);
+                continue;
+            }
+        }
+
+        try {
+            cache->index.insert(load_record(base, packed.get(), "subjects/" + n + "/" + n + ".subject", &yaml2subject));
+            cache->files[n] = st;
+        } catch (const std::exception &e) {
+            std::cerr << "[W] skipping unreadable subject: " << sf.path() << std::endl;
+        }
+    }
+
+    subjects = cache;
+    write_subject_cache(base, ipath, *subjects);
+}
+
+void store::invalidate(const store_event &ev) {
+    // the rgb2lms index re-validates itself on every lookup, but
+    // subject files edited in place go unnoticed by the subject cache
+    const bool stale = ev.what == store_event::kind::subject || ev.what == store_event::kind::store;
+
+    if (stale && subjects) {
+        subjects->dir_mtime = -1;
+    }
+}
+
+std::vector<iris::data::subject> store::find_subjects(const std::string &phrase, int how) {
+
+    if (service) {
+        try {
+            return service->find_subjects(phrase, how);
+        } catch (const wire_error &e) {
+            drop_service(e);
+        }
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        update_subject_cache(pass > 0);
+        std::vector<subject> hits = subjects->index.find(phrase, how);
+
+        // subject files edited in place do not change the dir mtime,
+        // so a miss or a changed hit triggers a re-stat of all files
+        bool stale = hits.empty() || std::any_of(hits.cbegin(), hits.cend(), [this](const subject &s) {
+            fs::file sf = base.child("subjects/" + s.identifier() + "/" + s.identifier() + ".subject");
+            auto known = subjects->files.find(s.identifier());
+            if (!sf.exists() || known == subjects->files.end()) {
+                return true;
+            }
+
+            fs::file::status st = sf.stat();
+            return st.size != known->second.size || st.mtime != known->second.mtime;
+        });
+
+        if (!stale) {
+            return hits;
+        }
+    }
+
+    return subjects->index.find(phrase, how);
+}
+
+isoslant store::load_isoslant(const subject &subject) {
+    std::vector<std::string> res = list_dir("subjects/" + subject.identifier(),
+                                            fs::fn_matcher("*.isoslant"),
+                                            fs::scan_order::descending, 1);
+
     if (res.empty()) {
         throw std::runtime_error("Could not find isoslant for subject");
     }
 
-    fs::file sfile = res.front();
-    return yaml2isoslant(sfile.read_all());
+    return load_record(base, packed.get(), "subjects/" + subject.identifier() + "/" + res.front(), &yaml2isoslant);
 }
 
 display store::make_display(const monitor       &monitor,
                             const monitor::mode &mode,
                             const std::string   &gfx) const
 {
+    if (service) {
+        try {
+            return service->make_display(monitor, mode, gfx);
+        } catch (const wire_error &e) {
+            drop_service(e);
+        }
+    }
 
-    fs::file linkfile = base.child("links.cfg");
-    std::string data = linkfile.read_all();
+    std::string data = read_file("links.cfg");
     YAML::Node root = YAML::Load(data);
 
     YAML::Node gfx_node = root[gfx];
@@ -280,8 +1179,7 @@ std::map<uint8_t, uint16_t> store::lpm_leds() const {
 
     std::map<uint8_t, uint16_t> lpm_led_map;
 
-    fs::file valuesFile = base.child("lpm/pwmLed");
-    std::string data = valuesFile.read_all();
+    std::string data = read_file("lpm/pwmLed");
     YAML::Node root = YAML::Load(data);
 
     YAML::Node led_node = root["leds"];
@@ -303,8 +1201,7 @@ std::map<uint8_t, uint16_t> store::lpm_leds() const {
 
         std::map<uint16_t, uint16_t>lpm_led_map;
 
-        fs::file valuesFile = base.child("lpm/pwm");
-        std::string data = valuesFile.read_all();
+        std::string data = read_file("lpm/pwm");
         YAML::Node root = YAML::Load(data);
 
         YAML::Node led_node = root["pwm"];
@@ -331,6 +1228,188 @@ fs::file store::cone_fundamentals(size_t spacing) const {
     return base.child(fn.str());
 }
 
+spectra store::load_cone_fundamentals(size_t spacing) const {
+    fs::file cf = cone_fundamentals(spacing);
+    std::string path = "cones/" + cf.name();
+
+    const store_pack::entry *e = packed ? packed->find(path) : nullptr;
+    if (e != nullptr && e->kind == pack_kind::spectra) {
+        fs::file::status st = cf.stat();
+        if (e->st.size == st.size && e->st.mtime == st.mtime) {
+            try {
+                return decode_spectra(*e);
+            } catch (const wire_error &ex) {
+                drop_snapshot(ex);
+            }
+        }
+    }
+
+    return spectra::from_csv(cf);
+}
+
+// store snapshot
+
+std::string store::read_file(const std::string &path) const {
+    fs::file f = base.child(path);
+
+    const store_pack::entry *e = packed ? packed->find(path) : nullptr;
+    if (e != nullptr && e->kind == pack_kind::file) {
+        fs::file::status st = f.stat();
+        if (e->st.size == st.size && e->st.mtime == st.mtime) {
+            return e->content();
+        }
+    }
+
+    return f.read_all();
+}
+
+static std::vector<std::string> entry_names(const std::vector<fs::dir_entry> &entries) {
+    std::vector<std::string> names(entries.size());
+    std::transform(entries.cbegin(), entries.cend(), names.begin(), [](const fs::dir_entry &e) {
+        return e.name;
+    });
+    return names;
+}
+
+std::vector<std::string> store::list_dir(const std::string &path,
+                                         const fs::fn_matcher &filter,
+                                         fs::scan_order order,
+                                         size_t limit) const {
+    fs::file dir = base.child(path);
+
+    const store_pack::entry *e = packed ? packed->find(path) : nullptr;
+    if (e != nullptr && e->kind == pack_kind::dir && dir.exists() && dir.stat().mtime == e->st.mtime) {
+        try {
+            std::vector<fs::dir_entry> entries;
+            for (std::string &n : decode_dir(*e)) {
+                if (filter(n)) {
+                    entries.push_back(fs::dir_entry{std::move(n), fs::dir_entry::kind::unknown});
+                }
+            }
+
+            fs::order_entries(entries, order, limit);
+            return entry_names(entries);
+        } catch (const wire_error &ex) {
+            drop_snapshot(ex);
+        }
+    }
+
+    return entry_names(fs::scan(dir, filter, order, limit));
+}
+
+void store::pack(const fs::file &path) const {
+    pack_writer w;
+
+    // stat before reading: a change after that gives a new mtime; a
+    // racy mtime is recorded as -1, so that entry is never used
+    auto status = [](const fs::file &f) {
+        fs::file::status st = f.stat();
+        st.mtime = mtime_is_racy(st.mtime) ? -1 : st.mtime;
+        return st;
+    };
+
+    auto add_dir = [&](const std::string &rel) {
+        fs::file dir = base.child(rel);
+        if (!dir.is_directory()) {
+            return std::vector<std::string>();
+        }
+
+        fs::file::status st = status(dir);
+        std::vector<std::string> names = entry_names(fs::scan(dir));
+        w.add(rel, pack_kind::dir, st, encode_dir(names));
+        return names;
+    };
+
+    auto add_file = [&](const std::string &rel) {
+        fs::file f = base.child(rel);
+        if (f.exists() && !f.is_directory()) {
+            fs::file::status st = status(f);
+            w.add(rel, pack_kind::file, st, f.read_all());
+        }
+    };
+
+    // a broken file is not our problem, the tree serves it as before
+    auto try_add = [&](const std::string &rel, std::function<std::string(const std::string &)> encode, pack_kind kind) {
+        fs::file f = base.child(rel);
+        try {
+            fs::file::status st = status(f);
+            w.add(rel, kind, st, encode(f.read_all()));
+        } catch (const std::exception &e) {
+            std::cerr << "[W] not packing " << rel << ": " << e.what() << std::endl;
+        }
+    };
+
+    add_dir("");
+    add_file("version");
+    add_file("links.cfg");
+
+    fs::file dm_link = base.child("default.monitor");
+    if (dm_link.exists()) {
+        w.add("default.monitor", pack_kind::link, fs::file::status{0, -1}, dm_link.readlink().path());
+    }
+
+    for (const std::string &id : add_dir("monitors")) {
+        if (!base.child("monitors/" + id).is_directory()) {
+            continue;
+        }
+
+        for (const std::string &n : add_dir("monitors/" + id)) {
+            const std::string rel = "monitors/" + id + "/" + n;
+
+            if (n == id + ".monitor") {
+                try_add(rel, [](const std::string &data) {
+                    return encode_record(yaml2monitor(data));
+                }, pack_kind::record);
+            } else if (fs::fn_matcher("*.rgb2lms")(n)) {
+                try_add(rel, [](const std::string &data) {
+                    return encode_record(yaml2rgb2lms(data));
+                }, pack_kind::record);
+            }
+        }
+    }
+
+    for (const std::string &id : add_dir("subjects")) {
+        if (!base.child("subjects/" + id).is_directory()) {
+            continue;
+        }
+
+        for (const std::string &n : add_dir("subjects/" + id)) {
+            const std::string rel = "subjects/" + id + "/" + n;
+
+            if (n == id + ".subject") {
+                try_add(rel, [](const std::string &data) {
+                    return encode_record(yaml2subject(data));
+                }, pack_kind::record);
+            } else if (fs::fn_matcher("*.isoslant")(n)) {
+                try_add(rel, [](const std::string &data) {
+                    return encode_record(yaml2isoslant(data));
+                }, pack_kind::record);
+            }
+        }
+    }
+
+    for (const std::string &n : add_dir("lpm")) {
+        add_file("lpm/" + n);
+    }
+
+    for (const std::string &n : add_dir("cones")) {
+        if (fs::fn_matcher("*.csv")(n)) {
+            try_add("cones/" + n, [](const std::string &data) {
+                return encode_spectra(spectra::from_csv(data));
+            }, pack_kind::spectra);
+        }
+    }
+
+    fs::file dir = path.parent();
+    if (!dir.exists()) {
+        dir.mkdir_with_parents();
+    }
+
+    // atomic: tools that have the old pack mapped keep it
+    fs::file out = path;
+    out.write_all(w.finish());
+}
+
 static iris::data::monitor::mode yaml2mode(const YAML::Node &node) {
     iris::data::monitor::mode mode;
 
@@ -546,6 +1625,18 @@ std::string store::isoslant2yaml(const isoslant &iso) {
 }
 
 
+isodata store::load_isodata(const fs::file &file, bool with_data) {
+    std::string raw = file.read_all();
+
+    if (!record_reader::is_record(raw)) {
+        return yaml2isodata(raw);
+    }
+
+    isodata data;
+    decode_record(record_reader(std::move(raw)), data, with_data);
+    return data;
+}
+
 isodata store::yaml2isodata(const std::string &str) {
     typedef csv_iterator<std::string::const_iterator> csv_siterator;
 
@@ -584,6 +1675,41 @@ isodata store::yaml2isodata(const std::string &str) {
         d.samples.emplace_back(stimulus, response);
     }
 
+    if (!root["trace"]) {
+        return d;
+    }
+
+    std::string td = root["trace"].as<std::string>();
+
+    is_header = true;
+    for (auto iter = csv_siterator(td.cbegin(), td.cend(), ',');
+         iter != csv_siterator();
+         ++iter) {
+        auto rec = *iter;
+
+        if (rec.is_comment() || rec.is_empty()) {
+            continue;
+        }
+
+        if (is_header) {
+            is_header = false;
+            continue;
+        }
+
+        if (rec.nfields() != 5) {
+            throw std::runtime_error("Invalid CSV data for isodata::trace");
+        }
+
+        isodata::estimate e;
+        e.trial = rec.get_size_t(0);
+        e.dl = rec.get_double(1);
+        e.phi = rec.get_double(2);
+        e.dl_ci = rec.get_double(3);
+        e.phi_ci = rec.get_double(4);
+
+        d.trace.push_back(e);
+    }
+
     return d;
 }
 
@@ -611,10 +1737,46 @@ std::string store::isodata2yaml(const isodata &data) {
     }
     out << cd.str();
 
+    if (!data.trace.empty()) {
+        std::stringstream td;
+
+        td << "trial, dl, phi, dl_ci, phi_ci";
+        for (const isodata::estimate &e : data.trace) {
+            td << std::endl;
+            td << e.trial << ", " << e.dl << ", " << e.phi << ", ";
+            td << e.dl_ci << ", " << e.phi_ci;
+        }
+
+        out << "trace" << YAML::Literal << td.str();
+    }
+
     out << YAML::EndMap;
     out << YAML::EndMap;
 
     return std::string(out.c_str());
 }
+
+std::string store::fit_report2yaml(const fit_report &report) {
+    YAML::Emitter out;
+
+    out << YAML::BeginMap;
+    out << "fit";
+    out << YAML::BeginMap;
+    out << "success" << report.success;
+    out << "info" << report.info;
+    out << "iterations" << report.iterations;
+    out << "nfev" << report.nfev;
+    out << "residual-norm" << report.residual_norm;
+    out << "wall-time" << report.wall_time;
+
+    out << "covariance" << YAML::Flow << report.covariance;
+    out << "trace" << YAML::Flow << report.trace;
+
+    out << YAML::EndMap;
+    out << YAML::EndMap;
+
+    return std::string(out.c_str());
+}
+
 } //iris::cfg::
 } //iris::
\ No newline at end of file
@@ -6,9 +6,12 @@
 #include <cstdint>
 
 #include <dkl.h>
+#include <fit.h>
 #include <fs.h>
 #include <spectra.h>
 #include <map>
+#include <memory>
+#include <unordered_map>
 
 namespace iris {
 namespace data {
@@ -91,6 +94,33 @@ struct subject : entity {
 
 };
 
+// in-memory index for subject lookups: a hash over the
+// lower-cased id, initials and name for exact queries, plus
+// a sorted list of the lower-cased names for prefix queries
+class subject_index {
+public:
+    enum match : int {
+        exact       = 0,
+        prefix      = 1 << 0,
+        ignore_case = 1 << 1
+    };
+
+    void insert(const subject &s);
+    void clear();
+
+    size_t size() const { return subjects.size(); }
+    const std::vector<subject> &all() const { return subjects; }
+
+    std::vector<subject> find(const std::string &phrase, int how = exact) const;
+
+private:
+    std::vector<subject> subjects;
+    std::unordered_multimap<std::string, size_t> keys;
+
+    mutable std::vector<std::pair<std::string, size_t>> names;
+    mutable bool names_sorted = true;
+};
+
 struct isodata : entity {
     using entity::entity;
 
@@ -101,9 +131,19 @@ struct isodata : entity {
         float response;
     };
 
+    // running isoslant estimate after a trial
+    struct estimate {
+        size_t trial;
+        double dl;
+        double phi;
+        double dl_ci;  // 95% confidence interval half-widths
+        double phi_ci;
+    };
+
     std::string subject; //the id
 
     std::vector<sample> samples;
+    std::vector<estimate> trace;
 
     //provenance metadata
     data::display display;
@@ -134,13 +174,46 @@ struct isoslant : entity {
  *     / links.cfg
  */
 
+// an entry of the store journal, see store::read_journal()
+struct journal_entry {
+    std::string op;   // "add"
+    std::string path; // relative to the store
+    fs::file::status st;
+    int64_t dir_mtime; // of the parent, right after the write
+};
+
+struct subject_cache;
+class store_client;
+class wire_error;
+class store_watcher;
+struct store_event;
+class store_pack;
+
 class store {
 public:
 
-    static store default_store();
+    // uses the store service (iris-stored) if one is running
+    static store default_store(bool use_service = true);
 
     fs::file location() const { return base; }
     std::string version_string() const;
+    bool is_served() const { return service != nullptr; }
+
+    // read-only snapshot used to speed up reads (see pack.h), from
+    // $IRIS_STORE_PACK or cache/store.pack; nullptr if none
+    std::shared_ptr<const store_pack> snapshot() const { return packed; }
+
+    // write a snapshot of the store to path
+    void pack(const fs::file &path) const;
+
+    // live change notifications (see watch.h), the store
+    // has to outlive the returned watcher
+    std::unique_ptr<store_watcher> watch();
+
+    // journal entries from offset on, offset is advanced past the
+    // last complete entry; false if the journal was reset (offset
+    // is then set to the current end, nothing is returned)
+    bool read_journal(uint64_t &offset, std::vector<journal_entry> &entries) const;
 
     //monitor functions
     std::string default_monitor() const;
@@ -154,15 +227,22 @@ public:
     rgb2lms  load_rgb2lms(const display &display) const;
     fs::file store_rgb2lms(const rgb2lms &rgb2lms);
 
+    // copies a data file (cac, spectra, ...) to path in the store;
+    // if the store has a file with the same content already, that
+    // one is hard linked instead. returns how the file was made
+    fs::copy_mode import_file(const fs::file &src, const std::string &path);
+
     //subject functions
     subject load_subject(const std::string &uid);
     isoslant load_isoslant(const subject &subject);
-    std::vector<iris::data::subject> find_subjects(const std::string &pharse);
+    std::vector<iris::data::subject> find_subjects(const std::string &pharse,
+                                                   int how = subject_index::exact);
 
     display make_display(const monitor &monitor, const monitor::mode &mode, const std::string &gfx) const;
 
     // cone fundamentals for calibration
     fs::file cone_fundamentals(size_t spacing = 4) const;
+    spectra load_cone_fundamentals(size_t spacing = 4) const;
 
     // the led mapping for the led pseudo monochromator
     std::map<uint8_t, uint16_t> lpm_leds() const;
@@ -182,14 +262,36 @@ public:
     static isoslant    yaml2isoslant(const std::string &data);
     static std::string isoslant2yaml(const isoslant &iso);
 
+    // YAML or binary record (see record.h); with_data = false
+    // skips the samples and trace of binary records
+    static isodata     load_isodata(const fs::file &file, bool with_data = true);
     static isodata     yaml2isodata(const std::string &data);
     static std::string isodata2yaml(const isodata &data);
 
+    static std::string fit_report2yaml(const fit_report &report);
+
 private:
     store(const fs::file &path);
 
+    void update_subject_cache(bool force);
+    void drop_service(const wire_error &e) const;
+    void drop_snapshot(const wire_error &e) const;
+
+    // tree access, served from the snapshot while it is up to date
+    std::string read_file(const std::string &path) const;
+    std::vector<std::string> list_dir(const std::string &path,
+                                      const fs::fn_matcher &filter = fs::fn_matcher("*"),
+                                      fs::scan_order order = fs::scan_order::none,
+                                      size_t limit = 0) const;
+
+    friend class store_watcher;
+    void invalidate(const store_event &ev);
+
 private:
     fs::file base;
+    std::shared_ptr<subject_cache> subjects;
+    mutable std::shared_ptr<store_client> service;
+    mutable std::shared_ptr<store_pack> packed;
 };
 
 } //iris::cfg
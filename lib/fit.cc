@@ -3,10 +3,12 @@
 
 #include <cminpack-1/cminpack.h>
 #include <iostream>
+#include <limits>
+#include <chrono>
 
 namespace iris {
 
-static int call_opt(void *p,
+int fitter::lm_eval(void *p,
                     int m,
                     int n,
                     const double *x,
@@ -14,23 +16,146 @@ static int call_opt(void *p,
                     int iflag)
 {
     fitter *opt = static_cast<fitter *>(p);
+
+    if (iflag == 0) {
+        // progress report (nprint > 0), fvec is current
+        double fnorm = enorm(m, fvec);
+        opt->rep.trace.push_back(fnorm);
+
+        if (opt->iter_cb) {
+            int iteration = static_cast<int>(opt->rep.trace.size()) - 1;
+            opt->iter_cb(iteration, x, fnorm);
+        }
+
+        return 0;
+    }
+
     return opt->eval(m, n, x, fvec);
 }
 
 
-bool fitter::operator()() {
-    double tol = tolerance();
+fit_report fitter::fit() {
+    auto start = std::chrono::steady_clock::now();
+
+    const double tol = tolerance();
     const int m = num_variables();
     const int n = num_parameter();
-    const int lwa = m*n+5*n+m;
-    std::vector<int> iwa(n);
-    std::vector<double> wa(lwa);
+
     std::vector<double> fvec(m);
+    std::vector<double> diag(n);
+    std::vector<double> fjac(m*n);
+    std::vector<int>    ipvt(n);
+    std::vector<double> qtf(n);
+    std::vector<double> wa1(n), wa2(n), wa3(n), wa4(m);
+
+    rep = fit_report();
+
+    // same settings as lmdif1, but report every iteration
+    const int maxfev = 200 * (n + 1);
+    const int nprint = 1;
+    int nfev = 0;
 
     double *p = params();
     void *user_data = static_cast<void *>(this);
-    fit_info = lmdif1(call_opt, user_data, m, n, p, fvec.data(), tol, iwa.data(), wa.data(), lwa);
-    return fit_info == 1 || fit_info == 2 || fit_info == 3;
+    rep.info = lmdif(lm_eval, user_data, m, n, p, fvec.data(),
+                     tol, tol, 0.0, maxfev, 0.0, diag.data(), 1, 100.0, nprint,
+                     &nfev, fjac.data(), m, ipvt.data(), qtf.data(),
+                     wa1.data(), wa2.data(), wa3.data(), wa4.data());
+
+    rep.success = rep.info == 1 || rep.info == 2 || rep.info == 3;
+    rep.nfev = nfev;
+    rep.iterations = std::max(static_cast<int>(rep.trace.size()) - 1, 0);
+    finish_report();
+
+    auto end = std::chrono::steady_clock::now();
+    rep.wall_time = std::chrono::duration<double>(end - start).count();
+    return rep;
+}
+
+// residual norm and covariance for the current parameters, the
+// jacobian is obtained by forward differences (n evaluations)
+void fitter::finish_report() {
+    const int m = num_variables();
+    const int n = num_parameter();
+    double *p = params();
+
+    std::vector<double> f0(m), f1(m);
+    eval(m, n, p, f0.data());
+    rep.residual_norm = enorm(m, f0.data());
+
+    rep.covariance.assign(n*n, std::numeric_limits<double>::quiet_NaN());
+
+    if (m <= n) {
+        return;
+    }
+
+    std::vector<double> J(m*n);
+    const double eps = std::sqrt(std::numeric_limits<double>::epsilon());
+    for (int j = 0; j < n; j++) {
+        const double pj = p[j];
+        const double h = eps * std::max(std::abs(pj), 1.0);
+        p[j] = pj + h;
+        eval(m, n, p, f1.data());
+        p[j] = pj;
+
+        for (int i = 0; i < m; i++) {
+            J[i*n + j] = (f1[i] - f0[i]) / h;
+        }
+    }
+
+    // solve (J'J) C = sigma^2 * I via gauss-jordan elimination
+    std::vector<double> A(n*n, 0.0);
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            for (int i = 0; i < m; i++) {
+                A[r*n + c] += J[i*n + r] * J[i*n + c];
+            }
+        }
+    }
+
+    const double sigma2 = rep.residual_norm * rep.residual_norm / (m - n);
+    std::vector<double> C(n*n, 0.0);
+    for (int i = 0; i < n; i++) {
+        C[i*n + i] = sigma2;
+    }
+
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (std::abs(A[r*n + col]) > std::abs(A[pivot*n + col])) {
+                pivot = r;
+            }
+        }
+
+        if (A[pivot*n + col] == 0.0) {
+            return; // singular, leave it at NaN
+        }
+
+        for (int c = 0; c < n; c++) {
+            std::swap(A[col*n + c], A[pivot*n + c]);
+            std::swap(C[col*n + c], C[pivot*n + c]);
+        }
+
+        const double d = A[col*n + col];
+        for (int c = 0; c < n; c++) {
+            A[col*n + c] /= d;
+            C[col*n + c] /= d;
+        }
+
+        for (int r = 0; r < n; r++) {
+            const double f = A[r*n + col];
+            if (r == col || f == 0.0) {
+                continue;
+            }
+
+            for (int c = 0; c < n; c++) {
+                A[r*n + c] -= f * A[col*n + c];
+                C[r*n + c] -= f * C[col*n + c];
+            }
+        }
+    }
+
+    rep.covariance = C;
 }
 
 int gamma_fitter::eval(int m, int n, const double *p, double *fvec) const {
@@ -49,6 +174,38 @@ int gamma_fitter::eval(int m, int n, const double *p, double *fvec) const {
     return 0;
 }
 
+fit_report sin_fitter::fit() {
+
+    if (fit_frequency) {
+        return fitter::fit();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    sin_accumulator acc(fit_offset ? -1.0 : dc);
+    for (size_t i = 0; i < x.size(); i++) {
+        acc.add(x[i], y[i]);
+    }
+
+    rep = fit_report();
+    rep.success = acc.solve();
+
+    if (rep.success) {
+        p[0] = acc.amplitude();
+        p[1] = acc.phase();
+        if (fit_offset) {
+            p[2] = acc.offset();
+        }
+
+        rep.info = 1;
+        finish_report();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    rep.wall_time = std::chrono::duration<double>(end - start).count();
+    return rep;
+}
+
 int sin_fitter::eval(int m, int n, const double *p, double *fvec) const {
 
     size_t freq_idx = fit_offset ? 3 : 2;
@@ -66,6 +223,102 @@ int sin_fitter::eval(int m, int n, const double *p, double *fvec) const {
 }
 
 
+void sin_accumulator::add(double x, double y) {
+    const double cx = std::cos(x);
+    const double sx = std::sin(x);
+
+    if (!fit_offset) {
+        y -= dc;
+    }
+
+    n++;
+    sc += cx;
+    ss += sx;
+    sy += y;
+
+    scc += cx * cx;
+    sss += sx * sx;
+    scs += cx * sx;
+
+    scy += cx * y;
+    ssy += sx * y;
+    syy += y * y;
+}
+
+bool sin_accumulator::solve() {
+    const size_t k = fit_offset ? 3 : 2;
+
+    if (n < k) {
+        return false;
+    }
+
+    const double N = static_cast<double>(n);
+    double a, b;
+    double rss;
+    double cov_aa, cov_ab, cov_bb; // (X'X)^-1 for a, b
+
+    if (fit_offset) {
+        // | scc scs sc |   | a |   | scy |
+        // | scs sss ss | * | b | = | ssy |
+        // | sc  ss  N  |   | c |   | sy  |
+        const double m00 = sss * N - ss * ss;
+        const double m01 = sc * ss - scs * N;
+        const double m02 = scs * ss - sc * sss;
+        const double m11 = scc * N - sc * sc;
+        const double m12 = sc * scs - scc * ss;
+        const double m22 = scc * sss - scs * scs;
+
+        const double det = scc * m00 + scs * m01 + sc * m02;
+        if (!std::isfinite(det) || std::abs(det) <= 1e-12 * N * N * N) {
+            return false;
+        }
+
+        a = (m00 * scy + m01 * ssy + m02 * sy) / det;
+        b = (m01 * scy + m11 * ssy + m12 * sy) / det;
+        c = (m02 * scy + m12 * ssy + m22 * sy) / det;
+
+        rss = syy - (a * scy + b * ssy + c * sy);
+        cov_aa = m00 / det;
+        cov_ab = m01 / det;
+        cov_bb = m11 / det;
+    } else {
+        const double det = scc * sss - scs * scs;
+        if (!std::isfinite(det) || std::abs(det) <= 1e-12 * N * N) {
+            return false;
+        }
+
+        a = (sss * scy - scs * ssy) / det;
+        b = (scc * ssy - scs * scy) / det;
+        c = dc;
+
+        rss = syy - (a * scy + b * ssy);
+        cov_aa = sss / det;
+        cov_ab = -scs / det;
+        cov_bb = scc / det;
+    }
+
+    A = std::hypot(a, b);
+    phi = std::atan2(b, a);
+
+    if (n == k || A == 0.0) {
+        A_err = phi_err = std::numeric_limits<double>::infinity();
+        return true;
+    }
+
+    // propagate the parameter covariance sigma^2 * (X'X)^-1
+    // to amplitude and phase via their gradients w.r.t. (a, b)
+    const double sigma2 = std::max(rss, 0.0) / static_cast<double>(n - k);
+    const double A2 = A * A;
+
+    const double var_A = (a * a * cov_aa + 2 * a * b * cov_ab + b * b * cov_bb) / A2;
+    const double var_phi = (b * b * cov_aa - 2 * a * b * cov_ab + a * a * cov_bb) / (A2 * A2);
+
+    A_err = std::sqrt(sigma2 * var_A);
+    phi_err = std::sqrt(sigma2 * var_phi);
+
+    return true;
+}
+
 int rgb2sml_fitter::eval(int m, int n, const double *p, double *fvec) const {
 
     const int N = m / (3*3);
@@ -7,11 +7,44 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <functional>
 
 namespace iris {
 
+// diagnostics of a single fit
+struct fit_report {
+    int    info = 0;          // minpack info code (0: not run, 1: closed form)
+    bool   success = false;
+    int    iterations = 0;
+    int    nfev = 0;          // function evaluations
+    double residual_norm = 0; // euclidean norm at the solution
+    double wall_time = 0;     // in seconds
+
+    // n x n (row-major) parameter covariance estimate, i.e.
+    // sigma^2 * (J'J)^-1, with sigma^2 = rss / (m - n)
+    std::vector<double> covariance;
+
+    // residual norm of the start point and after each iteration
+    std::vector<double> trace;
+};
+
 struct fitter {
-    virtual bool operator()();
+    typedef std::function<void(int iteration, const double *p, double residual_norm)> callback;
+
+    bool operator()() {
+        return fit().success;
+    }
+
+    virtual fit_report fit();
+
+    const fit_report &report() const {
+        return rep;
+    }
+
+    // called with the current parameters after every iteration
+    void on_iteration(const callback &cb) {
+        iter_cb = cb;
+    }
 
     //interface to be implemented
     virtual int eval(int m, int n, const double *p, double *fvec) const = 0;
@@ -25,8 +58,16 @@ struct fitter {
         return 1.49012e-8;
     }
 
+    virtual ~fitter() { }
+
 protected:
-    int fit_info;
+    void finish_report();
+
+    fit_report rep;
+    callback   iter_cb;
+
+private:
+    static int lm_eval(void *p, int m, int n, const double *x, double *fvec, int iflag);
 };
 
 
@@ -106,6 +147,9 @@ public:
         p[freq_idx] = 1; // frequency
     }
 
+    // closed form solution unless the frequency is fitted too
+    virtual fit_report fit() override;
+
     virtual int eval(int m, int n, const double *p, double *fvec) const override;
 
     virtual int num_parameter() const override {
@@ -137,6 +181,43 @@ public:
     size_t freq_idx;
 };
 
+// linear least squares fit of offset + A*cos(x - phi) with a fixed
+// frequency of 1. The model is linear in a = A*cos(phi), b = A*sin(phi)
+// and the offset, so the normal equations are accumulated one sample
+// at a time and then solved in closed form.
+class sin_accumulator {
+public:
+    sin_accumulator(double offset = -1) : fit_offset(offset < 0), dc(offset) { }
+
+    void add(double x, double y);
+    bool solve();
+
+    size_t samples() const { return n; }
+
+    double amplitude() const { return A; }
+    double phase() const { return phi; }
+    double offset() const { return fit_offset ? c : dc; }
+
+    // standard errors (infinite if there are no residual dof)
+    double amplitude_error() const { return A_err; }
+    double phase_error() const { return phi_err; }
+
+private:
+    bool fit_offset;
+    double dc;
+
+    size_t n = 0;
+
+    // sums over cos(x), sin(x) and y and their products
+    double sc = 0, ss = 0, sy = 0;
+    double scc = 0, sss = 0, scs = 0;
+    double scy = 0, ssy = 0, syy = 0;
+
+    // the solution
+    double A = 0, phi = 0, c = 0;
+    double A_err = 0, phi_err = 0;
+};
+
 class rgb2sml_fitter : public fitter {
 public:
     rgb2sml_fitter(const std::vector<double> &x, const std::vector<double> &y, const double weight_exponent = 1.1)
@@ -164,6 +245,11 @@ public:
         return res;
     }
 
+    // start from a previous calibration instead of the defaults
+    void seed(const dkl::parameter &init) {
+        memcpy(res, &init, sizeof(res));
+    }
+
     dkl::parameter rgb2sml() const {
         dkl::parameter pr;
         memcpy(&pr, res, sizeof(res));
@@ -2,13 +2,23 @@
 #include <fs.h>
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <fnmatch.h>
 #include <libgen.h>
 #include <pwd.h>
+#include <algorithm>
 #include <vector>
 #include <fstream>
 
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#endif
+
 namespace fs {
 
 dir_iterator::dir_iterator(const file &fd) : dir_iterator(fd.path()) {
@@ -30,8 +40,10 @@ void dir_iterator::next() {
 
     bool show_hidden = true;
 
+    // readdir(3) is safe as long as the stream is not shared
+    // between threads, readdir_r(3) is deprecated
     do {
-        readdir_r(dirp.get(), &buffer, &entry);
+        entry = ::readdir(dirp.get());
     } while(entry != nullptr && (!show_hidden && entry->d_name[0] == '.'));
 }
 
@@ -119,17 +131,37 @@ bool file::access(int mode) {
 
 bool file::exists() const {
     struct stat buf;
-    int res = stat(loc.c_str(), &buf);
+    int res = ::stat(loc.c_str(), &buf);
     return res == 0;
 }
 
 
 bool file::is_directory() const {
     struct stat buf;
-    int res = stat(loc.c_str(), &buf);
+    int res = ::stat(loc.c_str(), &buf);
     return res == 0 && S_ISDIR(buf.st_mode);
 }
 
+file::status file::stat() const {
+    struct stat buf;
+    int res = ::stat(loc.c_str(), &buf);
+
+    if (res != 0) {
+        throw std::runtime_error("Could not stat file: " + loc);
+    }
+
+#ifdef __APPLE__
+    const struct timespec &mt = buf.st_mtimespec;
+#else
+    const struct timespec &mt = buf.st_mtim;
+#endif
+
+    status st;
+    st.size = static_cast<uint64_t>(buf.st_size);
+    st.mtime = static_cast<int64_t>(mt.tv_sec) * 1000000000 + mt.tv_nsec;
+    return st;
+}
+
 file file::readlink() const {
 
     std::vector<char> buffer(1024, 0);
@@ -185,60 +217,331 @@ std::string file::read_all() const {
 }
 
 
-void file::write_all(const std::string &data) {
+static bool write_fd(int fd, const std::string &data, bool sync = true) {
+    const char *ptr = data.c_str();
+    size_t left = data.size();
 
-    bool file_exists = exists();
-    // todo: do atomic replace
-    //       make temp with mkstemp, write, rename
-    std::string filepath = loc;
+    while (left > 0) {
+        ssize_t n = ::write(fd, ptr, left);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            return false;
+        }
 
-    if (file_exists) {
-        char buffer[1024] = {0, };
-        fs::file parent_dir = parent();
-        snprintf(buffer, sizeof(buffer), "%s/.%sXXXXXX", parent_dir.path().c_str(), name().c_str());
-        filepath = mktemp(buffer);
+        ptr += n;
+        left -= static_cast<size_t>(n);
     }
 
-    std::ofstream fd(filepath, std::ios::binary | std::ios::trunc);
-    fd.write(data.c_str(), data.size());
-    fd.close();
+    return !sync || ::fsync(fd) == 0;
+}
 
-    if (!fd.good()) {
-        // hmm, clear out temporary file
-        throw std::runtime_error("Error wile writing data to file");
+static void sync_dir(const fs::file &dir) {
+    int fd = ::open(dir.path().c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd); // best effort, not supported everywhere
+        ::close(fd);
     }
+}
+
+// umask() can only be read by setting it, which races with other
+// threads creating files; so read it once before main() (there are
+// no threads yet) and later from /proc where the kernel has it
+static mode_t read_umask() {
+    mode_t mask = ::umask(0);
+    ::umask(mask);
+    return mask;
+}
+
+static const mode_t startup_umask = read_umask();
+
+static mode_t current_umask() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
 
-    if (file_exists) {
-        int res = rename(filepath.c_str(), path().c_str());
-        if (res != 0) {
-            unlink(filepath.c_str()); //ignore errors, can't do much
-            throw std::runtime_error("Atomic IO failed (rename)");
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "Umask:") == 0) {
+            try {
+                return static_cast<mode_t>(std::stoul(line.substr(6), nullptr, 8));
+            } catch (const std::exception &) {
+                break;
+            }
         }
     }
 
+    return startup_umask;
+}
+
+// a temporary file next to target, to be moved into place by
+// commit_temp(); returns the fd and sets tmppath
+static int make_temp(const fs::file &target, std::string &tmppath) {
+    std::string tmpl = target.parent().path() + "/." + target.name() + ".XXXXXX";
+    std::vector<char> buffer(tmpl.cbegin(), tmpl.cend());
+    buffer.push_back('\0');
+
+    int fd = ::mkstemp(buffer.data());
+    if (fd < 0) {
+        throw std::runtime_error("Could not create temporary file for: " + target.path());
+    }
+
+    tmppath = buffer.data();
+
+    // mkstemp uses 0600; keep the mode of the file we replace,
+    // or make it look like any other new file
+    struct stat st;
+    if (::stat(target.path().c_str(), &st) == 0) {
+        ::fchmod(fd, st.st_mode & 07777);
+    } else {
+        ::fchmod(fd, 0666 & ~current_umask());
+    }
+
+    return fd;
+}
+
+static void commit_temp(const std::string &tmppath, const fs::file &target, bool overwrite, bool sync = true) {
+    const std::string &loc = target.path();
+
+    int res;
+    if (overwrite) {
+        res = ::rename(tmppath.c_str(), loc.c_str());
+    } else {
+        // link() fails if the target exists, even over NFS
+        res = ::link(tmppath.c_str(), loc.c_str());
+        int err = errno;
+
+        if (res != 0 && (err == EPERM || err == EOPNOTSUPP)) {
+            // no hard links on this fs, callers have to lock then
+            err = target.exists() ? EEXIST : 0;
+            res = err ? -1 : ::rename(tmppath.c_str(), loc.c_str());
+        } else {
+            ::unlink(tmppath.c_str());
+        }
+
+        if (res != 0 && err == EEXIST) {
+            ::unlink(tmppath.c_str());
+            throw std::runtime_error("File exists: " + loc);
+        }
+    }
+
+    if (res != 0) {
+        ::unlink(tmppath.c_str()); //ignore errors, can't do much
+        throw std::runtime_error("Atomic IO failed (rename)");
+    }
+
+    if (sync) {
+        sync_dir(target.parent());
+    }
+}
+
+void file::write_all(const std::string &data, bool overwrite, bool durable) {
+
+    // readers must never see partial data: write to a temporary
+    // file next to us, sync it and then move it into place
+    std::string tmppath;
+    int fd = make_temp(*this, tmppath);
+
+    bool ok = write_fd(fd, data, durable);
+    ok = ::close(fd) == 0 && ok;
+
+    if (!ok) {
+        ::unlink(tmppath.c_str());
+        throw std::runtime_error("Error wile writing data to file");
+    }
+
+    commit_temp(tmppath, *this, overwrite, durable);
+}
+
+static const size_t io_buffer_size = 1024 * 1024;
+
+// share the data blocks of in with out (reflink), btrfs, xfs & co.
+static bool clone_fd(int in, int out) {
+#ifdef FICLONE
+    return ::ioctl(out, FICLONE, in) == 0;
+#else
+    return false;
+#endif
 }
 
+// copies from the current offset of in to its end; every method
+// continues where the one before it gave up
+static bool copy_fd(int in, int out) {
+
+#ifdef SYS_copy_file_range
+    // in-kernel copy, server side on NFS 4.2, might reflink as well
+    while (true) {
+        ssize_t n = ::syscall(SYS_copy_file_range, in, nullptr, out, nullptr, io_buffer_size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            if (n == 0) {
+                return true;
+            }
+            break; // EXDEV, ENOSYS, EINVAL, ...
+        }
+    }
+#endif
+
+#ifdef __linux__
+    while (true) {
+        ssize_t n = ::sendfile(out, in, nullptr, io_buffer_size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            if (n == 0) {
+                return true;
+            }
+            break;
+        }
+    }
+#endif
+
+    std::vector<char> buffer(io_buffer_size);
+
+    while (true) {
+        ssize_t n = ::read(in, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            return false;
+        } else if (n == 0) {
+            return true;
+        }
+
+        const char *ptr = buffer.data();
+        size_t left = static_cast<size_t>(n);
 
-void file::copy(fs::file &dest, bool overwrite) const {
+        while (left > 0) {
+            ssize_t k = ::write(out, ptr, left);
+            if (k < 0 && errno == EINTR) {
+                continue;
+            } else if (k < 0) {
+                return false;
+            }
+
+            ptr += k;
+            left -= static_cast<size_t>(k);
+        }
+    }
+}
+
+copy_mode file::copy(fs::file &dest, bool overwrite, copy_mode mode) const {
 
     if (dest.exists() && !overwrite) {
         throw std::runtime_error("destination exists");
     }
 
-    std::fstream input(path(), std::ios::in | std::ios::binary);
-    std::fstream output(dest.path(), std::ios::out | std::ios::binary);
+    if (mode == copy_mode::link) {
+        if (!overwrite && ::link(loc.c_str(), dest.path().c_str()) == 0) {
+            sync_dir(dest.parent());
+            return copy_mode::link;
+        } else if (!overwrite && errno == EEXIST) {
+            throw std::runtime_error("destination exists");
+        } else if (overwrite) {
+            std::string tmppath;
+            ::close(make_temp(dest, tmppath));
+            ::unlink(tmppath.c_str());
+
+            if (::link(loc.c_str(), tmppath.c_str()) == 0) {
+                commit_temp(tmppath, dest, true);
+                return copy_mode::link;
+            }
+        }
+
+        // different fs, no hard links on this fs, ...
+        mode = copy_mode::clone;
+    }
+
+    int in = ::open(loc.c_str(), O_RDONLY);
+    if (in < 0) {
+        throw std::runtime_error("Could not open file for reading: " + loc);
+    }
 
-    char buffer[4096];
+    std::string tmppath;
+    int out;
 
-    while (output.good() && input.good()) {
-        input.read(buffer, sizeof(buffer));
-        std::streamsize nread = input.gcount();
-        output.write(buffer, nread);
+    try {
+        out = make_temp(dest, tmppath);
+    } catch (...) {
+        ::close(in);
+        throw;
     }
 
-    if ((!input.good() && !input.eof()) || !output.good()) {
+    bool cloned = mode == copy_mode::clone && clone_fd(in, out);
+    bool ok = (cloned || copy_fd(in, out)) && ::fsync(out) == 0;
+
+    ::close(in);
+    ok = ::close(out) == 0 && ok;
+
+    if (!ok) {
+        ::unlink(tmppath.c_str());
         throw std::runtime_error("copy error: IO error");
     }
+
+    commit_temp(tmppath, dest, overwrite);
+    return cloned ? copy_mode::clone : copy_mode::copy;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// MurmurHash3 style mixing of 8 byte words
+uint64_t file::content_hash() const {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    int fd = ::open(loc.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file for reading: " + loc);
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    std::vector<char> buffer(io_buffer_size);
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    uint64_t total = 0;
+
+    while (true) {
+        ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            ::close(fd);
+            throw std::runtime_error("Error while reading data from file");
+        } else if (n == 0) {
+            break;
+        }
+
+        // short reads are only expected at the end of the file,
+        // otherwise the hash would depend on the read sizes
+        total += static_cast<uint64_t>(n);
+        size_t nwords = static_cast<size_t>(n) / 8;
+
+        for (size_t i = 0; i < nwords + (n % 8 ? 1 : 0); i++) {
+            uint64_t k = 0;
+            memcpy(&k, buffer.data() + i * 8, i < nwords ? 8 : n % 8);
+
+            k *= c1;
+            k = rotl64(k, 31);
+            k *= c2;
+
+            h ^= k;
+            h = rotl64(h, 27) * 5 + 0x52dce729;
+        }
+    }
+
+    ::close(fd);
+
+    h ^= total;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
 }
 
 file file::current_directory() {
@@ -307,9 +610,10 @@ bool file::mkdir_with_parents() {
         iter = iter.parent();
     }
 
-    for (fs::file cf : parents) {
-        if (!cf.exists()) {
-            cf.mkdir();
+    // outermost first
+    for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
+        if (!it->exists()) {
+            it->mkdir();
         }
     }
 
@@ -320,12 +624,79 @@ bool file::path_is_absolute(const std::string &path) {
     return !path.empty() && path[0] == '/';
 }
 
+file_lock::file_lock(const file &path, bool exclusive) : fd(-1) {
+    fd = ::open(path.path().c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open lock file: " + path.path());
+    }
+
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = exclusive ? F_WRLCK : F_RDLCK;
+    fl.l_whence = SEEK_SET;
+
+    int res;
+    do {
+        res = ::fcntl(fd, F_SETLKW, &fl);
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not lock: " + path.path());
+    }
+}
+
+file_lock::~file_lock() {
+    ::close(fd); // releases the lock
+}
+
+static bool has_wildcards(const std::string &str) {
+    return str.find_first_of("*?[\\") != std::string::npos;
+}
+
 fn_matcher::fn_matcher(const std::string pattern, int flags)
-        :pattern(pattern), flags(flags) {
+        :pattern(pattern), flags(flags), how(kind::glob) {
+
+    // the flags change the meaning of the pattern, leave that to fnmatch
+    if (flags != 0) {
+        return;
+    }
 
+    if (pattern == "*") {
+        how = kind::all;
+    } else if (!has_wildcards(pattern)) {
+        how = kind::exact;
+        literal = pattern;
+    } else if (pattern.front() == '*' && !has_wildcards(pattern.substr(1))) {
+        how = kind::suffix;
+        literal = pattern.substr(1);
+    } else if (pattern.back() == '*' && !has_wildcards(pattern.substr(0, pattern.size() - 1))) {
+        how = kind::prefix;
+        literal = pattern.substr(0, pattern.size() - 1);
+    }
 }
 
-bool fn_matcher::operator()(const std::string &str_to_match) {
+bool fn_matcher::operator()(const std::string &str_to_match) const {
+    const std::string &str = str_to_match;
+
+    switch (how) {
+    case kind::all:
+        return true;
+
+    case kind::exact:
+        return str == literal;
+
+    case kind::prefix:
+        return str.compare(0, literal.size(), literal) == 0;
+
+    case kind::suffix:
+        return str.size() >= literal.size() &&
+               str.compare(str.size() - literal.size(), literal.size(), literal) == 0;
+
+    case kind::glob:
+        break;
+    }
+
     int res = ::fnmatch(pattern.c_str(), str_to_match.c_str(), flags);
 
     if (res == 0) {
@@ -338,7 +709,130 @@ bool fn_matcher::operator()(const std::string &str_to_match) {
 }
 
 
-bool fn_matcher::operator()(const fs::file &the_file) {
+bool fn_matcher::operator()(const fs::file &the_file) const {
     return this->operator()(the_file.name());
 }
-}
\ No newline at end of file
+
+// directory scanning
+
+bool dir_entry::is_directory(const file &parent) const {
+    if (type == kind::directory) {
+        return true;
+    } else if (type != kind::unknown && type != kind::symlink) {
+        return false;
+    }
+
+    return parent.child(name).is_directory();
+}
+
+static dir_entry::kind entry_kind(unsigned char d_type) {
+    switch (d_type) {
+#ifdef DT_UNKNOWN
+    case DT_REG: return dir_entry::kind::regular;
+    case DT_DIR: return dir_entry::kind::directory;
+    case DT_LNK: return dir_entry::kind::symlink;
+    case DT_UNKNOWN: return dir_entry::kind::unknown;
+    default: return dir_entry::kind::other;
+#else
+    default: return dir_entry::kind::unknown;
+#endif
+    }
+}
+
+static void scan_add(std::vector<dir_entry> &entries, const fn_matcher &filter,
+                     const char *name, unsigned char d_type) {
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        return;
+    }
+
+    dir_entry e;
+    e.name = name;
+
+    if (filter(e.name)) {
+        e.type = entry_kind(d_type);
+        entries.push_back(std::move(e));
+    }
+}
+
+std::vector<dir_entry> scan(const file &dir, const fn_matcher &filter, scan_order order, size_t limit) {
+    std::vector<dir_entry> entries;
+
+#if defined(__linux__) && defined(SYS_getdents64)
+    int fd = ::open(dir.path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return entries; // like dir_iterator
+    }
+
+    // struct linux_dirent64 is not in the libc headers:
+    // u64 ino, s64 off, u16 reclen, u8 type, name
+    const size_t reclen_off = 16;
+    const size_t type_off = 18;
+    const size_t name_off = 19;
+
+    std::vector<char> buffer(32 * 1024);
+
+    while (true) {
+        long n = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not read directory: " + dir.path());
+        } else if (n == 0) {
+            break;
+        }
+
+        for (long pos = 0; pos < n; ) {
+            const char *rec = buffer.data() + pos;
+
+            uint16_t reclen;
+            memcpy(&reclen, rec + reclen_off, sizeof(reclen));
+
+            scan_add(entries, filter, rec + name_off, static_cast<unsigned char>(rec[type_off]));
+            pos += reclen;
+        }
+    }
+
+    ::close(fd);
+#else
+    DIR *dirp = ::opendir(dir.path().c_str());
+    if (dirp == nullptr) {
+        return entries;
+    }
+
+    for (struct dirent *e = ::readdir(dirp); e != nullptr; e = ::readdir(dirp)) {
+#ifdef DT_UNKNOWN
+        scan_add(entries, filter, e->d_name, e->d_type);
+#else
+        scan_add(entries, filter, e->d_name, 0);
+#endif
+    }
+
+    ::closedir(dirp);
+#endif
+
+    order_entries(entries, order, limit);
+    return entries;
+}
+
+void order_entries(std::vector<dir_entry> &entries, scan_order order, size_t limit) {
+    const bool partial = limit > 0 && limit < entries.size();
+
+    if (order != scan_order::none) {
+        auto cmp = [order](const dir_entry &a, const dir_entry &b) {
+            return order == scan_order::ascending ? a.name < b.name : a.name > b.name;
+        };
+
+        if (partial) {
+            std::partial_sort(entries.begin(), entries.begin() + limit, entries.end(), cmp);
+        } else {
+            std::sort(entries.begin(), entries.end(), cmp);
+        }
+    }
+
+    if (partial) {
+        entries.resize(limit);
+    }
+}
+
+}
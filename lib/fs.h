@@ -6,12 +6,21 @@
 #include <memory>
 #include <dirent.h>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <vector>
 
 namespace fs {
 
 class file;
 
+// how file::copy() may share the data with the source
+enum class copy_mode {
+    copy,  // a private copy of the data
+    clone, // share the data blocks (reflink) where the fs can, else copy
+    link   // hard link, if that fails like clone
+};
+
 class dir_iterator {
 public:
     typedef std::input_iterator_tag iterator_category;
@@ -60,7 +69,6 @@ private:
     std::string basepath;
     std::shared_ptr<DIR> dirp;
     struct dirent *entry;
-    struct dirent  buffer;
 };
 
 class file {
@@ -89,6 +97,13 @@ public:
 
     bool is_directory() const;
 
+    struct status {
+        uint64_t size;
+        int64_t  mtime; // in ns since the epoch
+    };
+
+    status stat() const;
+
     file readlink() const;
 
     // IO
@@ -96,12 +111,21 @@ public:
     std::fstream stream(std::ios::openmode mode = std::ios::in|std::ios::out) const;
 
     std::string read_all() const;
-    void write_all(const std::string &data);
+
+    // atomic: readers either see the old or the new content; with
+    // overwrite = false it fails if the file exists (checked atomically);
+    // durable = false skips the fsyncs, for data that can be rebuilt
+    // (a crash might then leave the file empty or torn)
+    void write_all(const std::string &data, bool overwrite = true, bool durable = true);
 
 
+    // fast (non-cryptographic) 64 bit hash of the content
+    uint64_t content_hash() const;
+
     // fs functions
 
-    void copy(fs::file &dest, bool overwrite = false) const;
+    // atomic like write_all(); returns how the copy was made
+    copy_mode copy(fs::file &dest, bool overwrite = false, copy_mode mode = copy_mode::clone) const;
 
     // obtain files
 
@@ -141,17 +165,64 @@ private:
 };
 
 
+// advisory lock (fcntl, so it also works on NFS) held for the
+// lifetime of the object, blocks until it is granted; the lock
+// file is created if needed. fcntl locks belong to the process,
+// they do not exclude threads of the same process.
+class file_lock {
+public:
+    explicit file_lock(const file &path, bool exclusive = true);
+    ~file_lock();
+
+    file_lock(const file_lock &) = delete;
+    file_lock &operator=(const file_lock &) = delete;
+
+private:
+    int fd;
+};
+
+// the common patterns ("*.ext", "prefix*", literals) are matched
+// without fnmatch(3)
 class fn_matcher {
 public:
     fn_matcher(const std::string pattern, int flags = 0);
-    bool operator()(const std::string &str_to_match);
-    bool operator()(const fs::file &the_file);
+    bool operator()(const std::string &str_to_match) const;
+    bool operator()(const fs::file &the_file) const;
 
 private:
+    enum class kind { glob, all, exact, prefix, suffix };
+
     std::string pattern;
     int flags;
+    kind how;
+    std::string literal;
+};
+
+// an entry of a directory listing, see scan()
+struct dir_entry {
+    enum class kind : uint8_t { unknown, regular, directory, symlink, other };
+
+    std::string name;
+    kind type; // as reported by the file system, if it does
+
+    // uses stat(2) if the type is not known or a symlink
+    bool is_directory(const file &parent) const;
 };
 
+enum class scan_order { none, ascending, descending };
+
+// lists dir (without "." and ".."): reads the entries in large batches
+// (getdents64 on linux), no stat(2) calls. The entries can be filtered
+// by name and ordered by name; with limit > 0 only the first limit
+// entries are kept, e.g. the newest of a set of timestamped files.
+std::vector<dir_entry> scan(const file &dir,
+                            const fn_matcher &filter = fn_matcher("*"),
+                            scan_order order = scan_order::none,
+                            size_t limit = 0);
+
+// the ordering and truncation done by scan()
+void order_entries(std::vector<dir_entry> &entries, scan_order order, size_t limit);
+
 }
 
 
@@ -0,0 +1,386 @@
+#include "AsyncWriter.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace h5x {
+
+// [rows] for width 1, [rows x width] otherwise
+static NDSize rowShape(ndsize_t rows, size_t width) {
+    NDSize shape(width == 1 ? 1 : 2);
+    shape[0] = rows;
+    if (width > 1) {
+        shape[1] = width;
+    }
+    return shape;
+}
+
+// rows per chunk of a [rows x width] column, single values get more
+static const ndsize_t chunkRows = 64;
+
+// upper bound for how long either side sleeps without being woken
+static const std::chrono::milliseconds maxWait(100);
+
+
+AsyncWriter::AsyncWriter(const std::string &path,
+                         const std::string &mode,
+                         size_t capacity,
+                         std::chrono::milliseconds flushInterval)
+    : ring(capacity), head(0), tail(0), consumerWaiting(false), producerWaiting(false),
+      failed(false), flushed(0), flushes(0), interval(flushInterval),
+      batchRows(0), dirty(false) {
+
+    if (capacity == 0) {
+        throw std::invalid_argument("AsyncWriter: capacity must not be 0");
+    }
+
+    std::promise<void> opened;
+    std::future<void> ready = opened.get_future();
+
+    io = std::thread(&AsyncWriter::run, this, path, mode, &opened);
+
+    try {
+        ready.get();
+    } catch (...) {
+        io.join();
+        throw;
+    }
+}
+
+
+AsyncWriter::~AsyncWriter() {
+    try {
+        close();
+    } catch (...) {
+        // close() explicitly to see errors
+    }
+}
+
+// producer side
+
+size_t AsyncWriter::column(const std::string &name, TypeId dtype, size_t width,
+                          const DataSetOptions &opts) {
+    auto it = names.find(name);
+    if (it != names.end()) {
+        const ColumnInfo &ci = info[it->second];
+        if (ci.dtype != dtype || ci.width != width) {
+            throw std::invalid_argument("AsyncWriter: column " + name + " redefined");
+        }
+        return it->second;
+    }
+
+    if (width == 0) {
+        throw std::invalid_argument("AsyncWriter: column " + name + " has width 0");
+    }
+
+    post([this, name, dtype, width, opts](File &fd) {
+        openColumn(fd, name, dtype, width, opts);
+    });
+
+    size_t idx = info.size();
+    info.push_back(ColumnInfo{name, dtype, width, width * data_type_to_size(dtype)});
+    names[name] = idx;
+    return idx;
+}
+
+
+void AsyncWriter::append(const Cell *cells, size_t n) {
+    check();
+
+    Slot &s = acquire();
+    s.kind = SlotKind::Row;
+    s.data.clear();
+    s.cells.clear();
+
+    for (size_t i = 0; i < n; i++) {
+        const ColumnInfo &ci = info.at(cells[i].column);
+        const char *p = static_cast<const char *>(cells[i].data);
+
+        s.cells.emplace_back(cells[i].column, s.data.size());
+        s.data.insert(s.data.end(), p, p + ci.nbytes);
+    }
+
+    publish();
+}
+
+
+void AsyncWriter::post(Task task) {
+    check();
+
+    Slot &s = acquire();
+    s.kind = SlotKind::Task;
+    s.task = std::move(task);
+
+    publish();
+}
+
+
+void AsyncWriter::flush() {
+    check();
+
+    Slot &s = acquire();
+    s.kind = SlotKind::Flush;
+    s.seq = ++flushes;
+
+    publish();
+
+    std::unique_lock<std::mutex> l(lock);
+    while (flushed.load() < flushes && !failed.load()) {
+        producerWaiting.store(true);
+        wakeProducer.wait_for(l, maxWait);
+    }
+    producerWaiting.store(false);
+    l.unlock();
+
+    check();
+}
+
+
+void AsyncWriter::close() {
+    if (!io.joinable()) {
+        return;
+    }
+
+    // a failed I/O thread keeps draining, so there will be room
+    Slot &s = acquire();
+    s.kind = SlotKind::Stop;
+    publish();
+
+    io.join();
+
+    std::exception_ptr err = failed.load() ? error : nullptr;
+    error = std::make_exception_ptr(std::logic_error("AsyncWriter: writer is closed"));
+    failed.store(true);
+
+    if (err) {
+        std::rethrow_exception(err);
+    }
+}
+
+
+AsyncWriter::Slot &AsyncWriter::acquire() {
+    const size_t t = tail.load(std::memory_order_relaxed);
+
+    while (t - head.load() == ring.size()) {
+        std::unique_lock<std::mutex> l(lock);
+        producerWaiting.store(true);
+        if (t - head.load() == ring.size()) {
+            wakeProducer.wait_for(l, maxWait);
+        }
+        producerWaiting.store(false);
+    }
+
+    return ring[t % ring.size()];
+}
+
+
+void AsyncWriter::publish() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1);
+
+    if (consumerWaiting.load()) {
+        std::lock_guard<std::mutex> l(lock);
+        wakeConsumer.notify_one();
+    }
+}
+
+
+void AsyncWriter::check() {
+    if (failed.load()) {
+        std::rethrow_exception(error);
+    }
+}
+
+// I/O thread
+
+void AsyncWriter::run(std::string path, std::string mode, std::promise<void> *opened) {
+    File fd;
+
+    try {
+        fd = File::open(path, mode);
+        fd.check("AsyncWriter: could not open " + path);
+    } catch (...) {
+        opened->set_exception(std::current_exception());
+        return;
+    }
+
+    opened->set_value();
+    lastFlush = std::chrono::steady_clock::now();
+
+    process(fd);
+
+    try {
+        columns.clear();
+        fd.close();
+    } catch (...) {
+        if (!failed.load()) {
+            fail();
+        }
+    }
+}
+
+
+void AsyncWriter::process(File &fd) {
+    for (;;) {
+        const size_t h = head.load(std::memory_order_relaxed);
+
+        if (h == tail.load()) {
+            // idle: write out what was coalesced, then sleep
+            try {
+                if (!failed.load()) {
+                    writeBatch();
+
+                    if (dirty && std::chrono::steady_clock::now() - lastFlush >= interval) {
+                        fd.flush();
+                        dirty = false;
+                        lastFlush = std::chrono::steady_clock::now();
+                    }
+                }
+            } catch (...) {
+                fail();
+            }
+
+            std::unique_lock<std::mutex> l(lock);
+            consumerWaiting.store(true);
+            if (h == tail.load()) {
+                wakeConsumer.wait_for(l, maxWait);
+            }
+            consumerWaiting.store(false);
+            continue;
+        }
+
+        Slot &s = ring[h % ring.size()];
+        const bool stop = s.kind == SlotKind::Stop;
+
+        if (!failed.load()) {
+            try {
+                handle(fd, s);
+            } catch (...) {
+                fail();
+            }
+        }
+
+        if (s.kind == SlotKind::Task) {
+            s.task = nullptr;
+        } else if (s.kind == SlotKind::Flush) {
+            flushed.store(s.seq);
+            std::lock_guard<std::mutex> l(lock);
+            wakeProducer.notify_all();
+        }
+
+        head.store(h + 1);
+
+        if (producerWaiting.load()) {
+            std::lock_guard<std::mutex> l(lock);
+            wakeProducer.notify_all();
+        }
+
+        if (stop) {
+            return;
+        }
+    }
+}
+
+
+void AsyncWriter::handle(File &fd, Slot &s) {
+    switch (s.kind) {
+
+    case SlotKind::Row:
+        for (const auto &cell : s.cells) {
+            ColumnState &c = columns[cell.first];
+            if (c.npending == 0) {
+                order.push_back(cell.first);
+            }
+
+            const char *p = s.data.data() + cell.second;
+            c.pending.insert(c.pending.end(), p, p + c.nbytes);
+            c.npending++;
+        }
+
+        if (++batchRows >= ring.size()) {
+            writeBatch();
+        }
+        break;
+
+    case SlotKind::Task:
+        writeBatch();
+        s.task(fd);
+        break;
+
+    case SlotKind::Flush:
+    case SlotKind::Stop:
+        writeBatch();
+        fd.flush();
+        dirty = false;
+        lastFlush = std::chrono::steady_clock::now();
+        break;
+    }
+}
+
+
+void AsyncWriter::openColumn(File &fd, const std::string &name, TypeId dtype, size_t width,
+                             const DataSetOptions &opts) {
+    ColumnState c;
+    c.dtype = dtype;
+    c.width = width;
+    c.nbytes = width * data_type_to_size(dtype);
+    c.npending = 0;
+
+    boost::optional<DataSet> existing = fd.tryOpenData(name);
+
+    if (existing) {
+        c.ds = opts.cache ? fd.openData(name, *opts.cache) : *existing;
+        NDSize dims = c.ds.size();
+
+        if ((width == 1 && dims.size() != 1) || (width > 1 && (dims.size() != 2 || dims[1] != width))) {
+            throw std::runtime_error("AsyncWriter: shape mismatch for existing column " + name);
+        }
+
+        c.rows = dims[0];
+    } else {
+        DataSetOptions co = opts;
+        co.maxsize = rowShape(H5S_UNLIMITED, width);
+        if (!co.chunks) {
+            co.chunks = rowShape(width == 1 ? 16 * chunkRows : chunkRows, width);
+        }
+
+        c.ds = fd.createData(name, dtype, rowShape(0, width), co);
+        c.rows = 0;
+    }
+
+    columns.push_back(std::move(c));
+}
+
+
+void AsyncWriter::writeBatch() {
+    for (size_t idx : order) {
+        ColumnState &c = columns[idx];
+
+        c.ds.setExtent(rowShape(c.rows + c.npending, c.width));
+        c.ds.writeRows(c.dtype, c.pending.data(), c.rows, c.npending);
+
+        c.rows += c.npending;
+        c.npending = 0;
+        c.pending.clear();
+        dirty = true;
+    }
+
+    order.clear();
+    batchRows = 0;
+}
+
+
+void AsyncWriter::fail() {
+    error = std::current_exception();
+    failed.store(true);
+
+    for (ColumnState &c : columns) {
+        c.pending.clear();
+        c.npending = 0;
+    }
+    order.clear();
+
+    std::lock_guard<std::mutex> l(lock);
+    wakeProducer.notify_all();
+}
+
+} // h5x::
@@ -0,0 +1,147 @@
+#ifndef H5X_ASYNCWRITER_H
+#define H5X_ASYNCWRITER_H
+
+#include <h5x/File.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace h5x {
+
+/**
+ * Appends rows to a file from a dedicated I/O thread.
+ *
+ * The file and all HDF5 handles belong to the I/O thread; the
+ * (single) producer only copies rows into preallocated slots of a
+ * bounded lock-free ring. When the ring is full the producer blocks
+ * until the I/O thread catches up. Queued rows are coalesced into
+ * one setExtent + write per column, columns are written in the order
+ * they appear in a row. Errors on the I/O thread are rethrown on the
+ * producer by the next call; the writer is unusable after that.
+ *
+ * A column is a dataset with an unlimited first dimension, [rows]
+ * for width 1 and [rows x width] otherwise; existing datasets are
+ * continued. The file is flushed every flushInterval and on flush().
+ *
+ * Only one thread may use a writer at a time.
+ */
+class AsyncWriter {
+public:
+    typedef std::function<void(File &)> Task;
+
+    struct Cell {
+        size_t column;
+        const void *data; // width values of the column's type
+    };
+
+    AsyncWriter(const std::string &path,
+                const std::string &mode = "a",
+                size_t capacity = 256,
+                std::chrono::milliseconds flushInterval = std::chrono::seconds(10));
+
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter &) = delete;
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    // index of the column name, opened or created on first use;
+    // without explicit chunks in opts a chunk is a block of rows
+    size_t column(const std::string &name, TypeId dtype, size_t width = 1,
+                  const DataSetOptions &opts = DataSetOptions());
+
+    void append(const Cell *cells, size_t n);
+    void append(std::initializer_list<Cell> cells) { append(cells.begin(), cells.size()); }
+
+    // run task on the I/O thread, in order with the rows
+    void post(Task task);
+
+    // wait until everything queued so far is written and flushed
+    void flush();
+
+    void close();
+
+private:
+    enum class SlotKind { Row, Task, Flush, Stop };
+
+    struct Slot {
+        SlotKind kind;
+        std::vector<char> data;
+        std::vector<std::pair<size_t, size_t>> cells; // column, offset in data
+        Task task;
+        uint64_t seq; // of a Flush
+    };
+
+    struct ColumnInfo {
+        std::string name;
+        TypeId dtype;
+        size_t width;
+        size_t nbytes;
+    };
+
+    struct ColumnState {
+        DataSet ds;
+        TypeId dtype;
+        size_t width;
+        size_t nbytes;
+        ndsize_t rows;
+        std::vector<char> pending;
+        ndsize_t npending;
+    };
+
+    Slot &acquire();
+    void publish();
+    void check();
+
+    void run(std::string path, std::string mode, std::promise<void> *opened);
+    void process(File &fd);
+    void handle(File &fd, Slot &slot);
+    void openColumn(File &fd, const std::string &name, TypeId dtype, size_t width,
+                    const DataSetOptions &opts);
+    void writeBatch();
+    void fail();
+
+private:
+    std::vector<Slot> ring;
+    std::atomic<size_t> head; // next slot to consume
+    std::atomic<size_t> tail; // next slot to fill
+
+    std::mutex lock;
+    std::condition_variable wakeConsumer;
+    std::condition_variable wakeProducer;
+    std::atomic<bool> consumerWaiting;
+    std::atomic<bool> producerWaiting;
+
+    std::atomic<bool> failed;
+    std::exception_ptr error;
+
+    std::atomic<uint64_t> flushed;
+    uint64_t flushes;
+
+    std::chrono::milliseconds interval;
+    std::thread io;
+
+    // producer side
+    std::vector<ColumnInfo> info;
+    std::map<std::string, size_t> names;
+
+    // I/O thread side
+    std::vector<ColumnState> columns;
+    std::vector<size_t> order;
+    ndsize_t batchRows;
+    bool dirty;
+    std::chrono::steady_clock::time_point lastFlush;
+};
+
+} // h5x::
+
+#endif
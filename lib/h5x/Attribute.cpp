@@ -62,4 +62,10 @@ NDSize Attribute::extent() const {
     return getSpace().extent();
 }
 
+bool Attribute::isString() const {
+    DataType ftype = H5Aget_type(hid);
+    ftype.check("Attribute::isString(): could not get type");
+    return H5Tget_class(ftype.h5id()) == H5T_STRING;
+}
+
 } //h5x::
\ No newline at end of file
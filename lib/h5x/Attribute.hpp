@@ -30,6 +30,9 @@ public:
 
     DataSpace getSpace() const;
     NDSize extent() const;
+
+    // of class H5T_STRING (fixed or variable length)
+    bool isString() const;
 };
 
 } // h5x
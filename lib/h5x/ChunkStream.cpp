@@ -0,0 +1,339 @@
+#include <h5x/ChunkStream.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace h5x {
+
+// bytes of one row (first dimension) of a dataset of extent dims
+static size_t rowSize(const NDSize &dims, TypeId dtype) {
+    if (dtype == TypeId::String || dtype == TypeId::Nothing) {
+        throw std::invalid_argument("ChunkStream: cannot stream strings");
+    }
+    if (dims.size() == 0) {
+        throw std::invalid_argument("ChunkStream: cannot stream a scalar");
+    }
+
+    size_t n = data_type_to_size(dtype);
+    for (size_t i = 1; i < dims.size(); i++) {
+        n *= check::fits_in_size_t(dims[i], "ChunkStream: row too large");
+    }
+    return n;
+}
+
+// rows of a chunk, 1 for contiguous datasets
+static ndsize_t chunkRows(const DataSet &ds, size_t rank) {
+    HId dcpl = H5Dget_create_plist(ds.h5id());
+    dcpl.check("ChunkStream: could not get creation plist");
+
+    if (H5Pget_layout(dcpl.h5id()) != H5D_CHUNKED) {
+        return 1;
+    }
+
+    NDSize chunks(rank, 0);
+    int res = H5Pget_chunk(dcpl.h5id(), static_cast<int>(rank), chunks.data());
+    if (res < 0) {
+        throw H5Exception("ChunkStream: could not get chunk size");
+    }
+    return std::max<ndsize_t>(chunks[0], 1);
+}
+
+
+struct ChunkStream::Impl {
+    struct Output {
+        DataSet ds;
+        TypeId dtype;
+        NDSize dims;
+        size_t rowBytes;
+    };
+
+    struct Write {
+        size_t output;
+        ndsize_t start;
+        ndsize_t count;
+        std::vector<char> data;
+    };
+
+    DataSet ds;
+    TypeId dtype;
+    NDSize dims;
+    size_t rowBytes;
+    ndsize_t blockRows;
+    size_t depth;
+
+    std::vector<Output> outputs;
+
+    std::thread io;
+    std::mutex lock;
+    std::condition_variable wakeIO;
+    std::condition_variable wakeCaller;
+
+    bool stop = false;
+    bool reading = false;
+    ndsize_t nextRow = 0;  // of the next block to read
+    std::deque<std::unique_ptr<RowBlock>> ready;
+    std::vector<std::unique_ptr<RowBlock>> spare;
+    std::unique_ptr<RowBlock> current;
+
+    std::deque<Write> writes;
+    bool writing = false;
+
+    std::exception_ptr error;
+
+    void start();
+    void run();
+    void read(RowBlock &block);
+    void write(Write &w);
+    void join();
+};
+
+
+void ChunkStream::Impl::start() {
+    if (!io.joinable() && !stop) {
+        io = std::thread(&Impl::run, this);
+    }
+}
+
+
+void ChunkStream::Impl::run() {
+    std::unique_lock<std::mutex> l(lock);
+
+    for (;;) {
+        wakeIO.wait(l, [this] {
+            return stop || !writes.empty() || (nextRow < dims[0] && ready.size() < depth);
+        });
+
+        // writes first: they hold memory, and stop waits for them
+        if (!writes.empty()) {
+            Write w = std::move(writes.front());
+            writes.pop_front();
+            writing = true;
+
+            l.unlock();
+            try {
+                write(w);
+            } catch (...) {
+                l.lock();
+                error = std::current_exception();
+                writing = false;
+                wakeCaller.notify_all();
+                return;
+            }
+            l.lock();
+
+            writing = false;
+            wakeCaller.notify_all();
+            continue;
+        }
+
+        if (stop) {
+            return;
+        }
+
+        std::unique_ptr<RowBlock> block;
+        if (spare.empty()) {
+            block.reset(new RowBlock());
+        } else {
+            block = std::move(spare.back());
+            spare.pop_back();
+        }
+
+        block->start = nextRow;
+        block->rows = std::min(blockRows, dims[0] - nextRow);
+        nextRow += block->rows;
+        reading = true;
+
+        l.unlock();
+        try {
+            read(*block);
+        } catch (...) {
+            l.lock();
+            error = std::current_exception();
+            reading = false;
+            wakeCaller.notify_all();
+            return;
+        }
+        l.lock();
+
+        ready.push_back(std::move(block));
+        reading = false;
+        wakeCaller.notify_all();
+    }
+}
+
+
+void ChunkStream::Impl::read(RowBlock &block) {
+    block.shape = dims;
+    block.shape[0] = block.rows;
+    block.data.resize(check::fits_in_size_t(block.rows * rowBytes, "ChunkStream: block too large"));
+
+    ds.readRows(dtype, block.data.data(), block.start, block.rows);
+}
+
+
+void ChunkStream::Impl::write(Write &w) {
+    Output &out = outputs[w.output];
+
+    if (w.start + w.count > out.dims[0]) {
+        out.dims[0] = w.start + w.count;
+        out.ds.setExtent(out.dims);
+    }
+
+    out.ds.writeRows(out.dtype, w.data.data(), w.start, w.count);
+}
+
+
+void ChunkStream::Impl::join() {
+    {
+        std::lock_guard<std::mutex> l(lock);
+        stop = true;
+        wakeIO.notify_all();
+    }
+
+    if (io.joinable()) {
+        io.join();
+    }
+}
+
+
+ChunkStream::ChunkStream(const DataSet &ds, TypeId dtype, ndsize_t blockRows, size_t depth)
+    : impl(new Impl()) {
+
+    if (depth == 0) {
+        throw std::invalid_argument("ChunkStream: depth must not be 0");
+    }
+
+    impl->ds = ds;
+    impl->dtype = dtype;
+    impl->dims = ds.size();
+    impl->rowBytes = rowSize(impl->dims, dtype);
+    impl->depth = depth;
+
+    if (blockRows == 0) {
+        const ndsize_t chunk = chunkRows(ds, impl->dims.size());
+        const ndsize_t n = std::max<ndsize_t>(blockBytes / (chunk * impl->rowBytes), 1);
+        blockRows = chunk * n;
+    }
+
+    impl->blockRows = blockRows;
+}
+
+
+ChunkStream::ChunkStream(ChunkStream &&other) : impl(std::move(other.impl)) { }
+
+
+ChunkStream::~ChunkStream() {
+    try {
+        close();
+    } catch (...) {
+        // close() explicitly to see errors
+    }
+}
+
+
+ndsize_t ChunkStream::blockRows() const {
+    return impl->blockRows;
+}
+
+
+ndsize_t ChunkStream::rows() const {
+    return impl->dims[0];
+}
+
+
+size_t ChunkStream::output(const DataSet &ds, TypeId dtype) {
+    if (impl->io.joinable() || impl->stop) {
+        throw std::logic_error("ChunkStream: outputs must be added before iterating");
+    }
+
+    NDSize dims = ds.size();
+    impl->outputs.push_back(Impl::Output{ds, dtype, dims, rowSize(dims, dtype)});
+    return impl->outputs.size() - 1;
+}
+
+
+const RowBlock *ChunkStream::next() {
+    Impl &s = *impl;
+    s.start();
+
+    std::unique_lock<std::mutex> l(s.lock);
+
+    if (s.current) {
+        s.spare.push_back(std::move(s.current));
+    }
+
+    s.wakeCaller.wait(l, [&s] {
+        return s.error || !s.ready.empty() || s.stop ||
+               (s.nextRow >= s.dims[0] && !s.reading);
+    });
+
+    if (s.error) {
+        std::rethrow_exception(s.error);
+    }
+
+    if (s.ready.empty()) {
+        return nullptr;
+    }
+
+    s.current = std::move(s.ready.front());
+    s.ready.pop_front();
+    s.wakeIO.notify_all();
+
+    return s.current.get();
+}
+
+
+void ChunkStream::write(size_t output, const void *data, ndsize_t start, ndsize_t count) {
+    Impl &s = *impl;
+
+    const Impl::Output &out = s.outputs.at(output);
+    Impl::Write w{output, start, count, std::vector<char>()};
+
+    const char *p = static_cast<const char *>(data);
+    w.data.assign(p, p + check::fits_in_size_t(count * out.rowBytes, "ChunkStream: write too large"));
+
+    s.start();
+
+    std::unique_lock<std::mutex> l(s.lock);
+    s.wakeCaller.wait(l, [&s] {
+        return s.error || s.stop || s.writes.size() < s.depth;
+    });
+
+    if (s.error) {
+        std::rethrow_exception(s.error);
+    }
+    if (s.stop) {
+        throw std::logic_error("ChunkStream: stream is closed");
+    }
+
+    s.writes.push_back(std::move(w));
+    s.wakeIO.notify_all();
+}
+
+
+void ChunkStream::close() {
+    if (!impl) {
+        return;
+    }
+
+    impl->join();
+
+    if (impl->error) {
+        std::exception_ptr err = impl->error;
+        impl->error = nullptr;
+        std::rethrow_exception(err);
+    }
+}
+
+
+ChunkStream DataSet::chunks(TypeId dtype, ndsize_t blockRows) const {
+    return ChunkStream(*this, dtype, blockRows);
+}
+
+} // h5x::
@@ -0,0 +1,108 @@
+#ifndef H5X_CHUNKSTREAM_H
+#define H5X_CHUNKSTREAM_H
+
+#include <h5x/DataSet.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace h5x {
+
+/**
+ * Rows [start, start + rows) of a dataset, row-major.
+ */
+struct RowBlock {
+    ndsize_t start;
+    ndsize_t rows;
+    NDSize shape;  // rows x the rest of the dataset
+    std::vector<char> data;
+
+    template<typename T>
+    const T *as() const { return reinterpret_cast<const T *>(data.data()); }
+};
+
+
+/**
+ * Walks a dataset in blocks of whole rows, for data that does not fit
+ * into memory. By default a block is as many whole chunks (rows of a
+ * contiguous dataset) as fit into blockBytes, so every chunk is read
+ * exactly once. A helper thread reads up to depth blocks ahead while
+ * the caller works on the current one, and writes results to output
+ * datasets in the order they were queued.
+ *
+ * Once iteration started all HDF5 calls of the stream happen on the
+ * helper thread; unless the library is built thread-safe the caller
+ * must not use HDF5 (h5x objects included) until close().
+ *
+ *   ChunkStream s = ds.chunks(TypeId::Float);
+ *   size_t o = s.output(res, TypeId::Float);
+ *   for (const RowBlock &b : s) {
+ *       ... b.as<float>() ...
+ *       s.write(o, out.data(), b.start, b.rows);
+ *   }
+ *   s.close();
+ */
+class ChunkStream {
+public:
+    static const size_t blockBytes = 4 * 1024 * 1024;
+
+    ChunkStream(const DataSet &ds, TypeId dtype, ndsize_t blockRows = 0, size_t depth = 2);
+    ChunkStream(ChunkStream &&other);
+    ~ChunkStream();
+
+    ChunkStream(const ChunkStream &) = delete;
+    ChunkStream &operator=(const ChunkStream &) = delete;
+
+    ndsize_t blockRows() const;
+    ndsize_t rows() const;
+
+    // register an output before iterating; it is extended as needed
+    size_t output(const DataSet &ds, TypeId dtype);
+
+    // the next block or nullptr at the end, valid until the next call
+    const RowBlock *next();
+
+    // queue count rows of data (copied) for output rows from start,
+    // blocks while depth writes are pending
+    void write(size_t output, const void *data, ndsize_t start, ndsize_t count);
+
+    // wait for the pending writes, rethrows errors of the helper
+    void close();
+
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef RowBlock                value_type;
+        typedef std::ptrdiff_t          difference_type;
+        typedef const RowBlock         *pointer;
+        typedef const RowBlock         &reference;
+
+        iterator() : stream(nullptr), block(nullptr) { }
+        iterator(ChunkStream *stream) : stream(stream), block(stream->next()) { }
+
+        const RowBlock &operator*() const { return *block; }
+        const RowBlock *operator->() const { return block; }
+
+        iterator &operator++() { block = stream->next(); return *this; }
+
+        bool operator==(const iterator &o) const { return block == o.block; }
+        bool operator!=(const iterator &o) const { return block != o.block; }
+
+    private:
+        ChunkStream *stream;
+        const RowBlock *block;
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // h5x::
+
+#endif
@@ -9,8 +9,13 @@
 #include <h5x/DataSet.hpp>
 #include <h5x/Error.hpp>
 
-#include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 
 namespace h5x {
 
@@ -36,8 +41,18 @@ void DataSet::write(hid_t memType, const void *data)
     res.check("DataSet::write() IOError");
 }
 
+// H5S_ALL transfers everything, so the buffer must match the extent
+static void checkTransfer(const NDSize &extent, const NDSize &size, const char *what)
+{
+    if (extent.nelms() != size.nelms()) {
+        throw std::invalid_argument(std::string(what) + ": buffer of " + std::to_string(size.nelms()) +
+                                    " elements for a dataset of " + std::to_string(extent.nelms()));
+    }
+}
+
 void DataSet::read(TypeId dtype, const NDSize &size, void *data) const
 {
+    checkTransfer(this->size(), size, "DataSet::read()");
     DataType memType = data_type_to_h5_memtype(dtype);
 
     if (dtype == TypeId::String) {
@@ -53,6 +68,7 @@ void DataSet::read(TypeId dtype, const NDSize &size, void *data) const
 
 void DataSet::write(TypeId dtype, const NDSize &size, const void *data)
 {
+    checkTransfer(this->size(), size, "DataSet::write()");
     h5x::DataType memType = data_type_to_h5_memtype(dtype);
     if (dtype == TypeId::String) {
         StringReader reader(size, static_cast<const std::string *>(data));
@@ -103,6 +119,157 @@ void DataSet::write(TypeId         dtype,
     res.check("DataSet::write(): IO error");
 }
 
+// the memory space for n rows of a dataset with extent dims
+static DataSpace rowSpace(NDSize dims, ndsize_t n)
+{
+    dims[0] = n;
+    return DataSpace::create(dims, false);
+}
+
+// bytes per row, for reordering rows in memory
+static size_t rowBytes(const NDSize &dims, TypeId dtype)
+{
+    if (dtype == TypeId::String) {
+        throw std::invalid_argument("DataSet: rows of strings must be in ascending order");
+    }
+
+    size_t n = data_type_to_size(dtype);
+    for (size_t i = 1; i < dims.size(); i++) {
+        n *= check::fits_in_size_t(dims[i], "DataSet: row too large");
+    }
+    return n;
+}
+
+static bool ascending(const std::vector<ndsize_t> &rows)
+{
+    for (size_t i = 1; i < rows.size(); i++) {
+        if (rows[i] <= rows[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DataSet::readRows(TypeId dtype, void *data, ndsize_t start, ndsize_t count) const
+{
+    if (count == 0) {
+        return;
+    }
+
+    NDSize shape = size();
+    shape[0] = count;
+
+    NDSize offset(shape.size(), 0);
+    offset[0] = start;
+
+    Selection fsel = createSelection();
+    fsel.select(shape, offset);
+
+    read(dtype, data, fsel, Selection(DataSpace::create(shape, false)));
+}
+
+void DataSet::writeRows(TypeId dtype, const void *data, ndsize_t start, ndsize_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    NDSize shape = size();
+    shape[0] = count;
+
+    NDSize offset(shape.size(), 0);
+    offset[0] = start;
+
+    Selection fsel = createSelection();
+    fsel.select(shape, offset);
+
+    write(dtype, data, fsel, Selection(DataSpace::create(shape, false)));
+}
+
+void DataSet::readRows(TypeId dtype, void *data, const std::vector<ndsize_t> &rows) const
+{
+    if (rows.empty()) {
+        return;
+    }
+
+    NDSize dims = size();
+    const bool direct = ascending(rows);
+
+    if (direct && (dtype == TypeId::String || rows.back() - rows.front() + 1 == rows.size())) {
+        Selection fsel = Selection::rows(getSpace(), rows);
+        read(dtype, data, fsel, Selection(rowSpace(dims, rows.size())));
+        return;
+    }
+
+    // a selection is always transferred in file order
+    const size_t rb = rowBytes(dims, dtype);
+
+    std::vector<ndsize_t> sorted(rows);
+    if (!direct) {
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    }
+
+    // selecting many scattered rows is slower than reading all rows
+    // in between and picking them in memory, as long as they are dense
+    const ndsize_t span = sorted.back() - sorted.front() + 1;
+    const bool dense = span <= 4 * sorted.size();
+
+    std::vector<char> buffer((dense ? span : sorted.size()) * rb);
+
+    if (dense) {
+        readRows(dtype, buffer.data(), sorted.front(), span);
+    } else {
+        Selection fsel = Selection::rows(getSpace(), sorted);
+        read(dtype, buffer.data(), fsel, Selection(rowSpace(dims, sorted.size())));
+    }
+
+    char *out = static_cast<char *>(data);
+    for (size_t i = 0; i < rows.size(); i++) {
+        size_t k = dense ? rows[i] - sorted.front() :
+                   std::lower_bound(sorted.begin(), sorted.end(), rows[i]) - sorted.begin();
+        memcpy(out + i * rb, buffer.data() + k * rb, rb);
+    }
+}
+
+void DataSet::writeRows(TypeId dtype, const void *data, const std::vector<ndsize_t> &rows)
+{
+    if (rows.empty()) {
+        return;
+    }
+
+    NDSize dims = size();
+
+    if (ascending(rows)) {
+        Selection fsel = Selection::rows(getSpace(), rows);
+        write(dtype, data, fsel, Selection(rowSpace(dims, rows.size())));
+        return;
+    }
+
+    const size_t rb = rowBytes(dims, dtype);
+
+    std::vector<size_t> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&rows](size_t a, size_t b) {
+        return rows[a] < rows[b];
+    });
+
+    std::vector<ndsize_t> sorted(rows.size());
+    std::vector<char> buffer(rows.size() * rb);
+    const char *in = static_cast<const char *>(data);
+
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = rows[order[i]];
+        if (i > 0 && sorted[i] == sorted[i - 1]) {
+            throw std::invalid_argument("DataSet::writeRows(): duplicate row");
+        }
+        memcpy(buffer.data() + i * rb, in + order[i] * rb, rb);
+    }
+
+    Selection fsel = Selection::rows(getSpace(), sorted);
+    write(dtype, buffer.data(), fsel, Selection(rowSpace(dims, sorted.size())));
+}
+
 #define CHUNK_BASE   16*1024
 #define CHUNK_MIN     8*1024
 #define CHUNK_MAX  1024*1024
@@ -212,6 +379,12 @@ NDSize DataSet::size() const
     return getSpace().extent();
 }
 
+void DataSet::refresh()
+{
+    HErr res = H5Drefresh(hid);
+    res.check("DataSet::refresh(): Could not refresh");
+}
+
 void DataSet::vlenReclaim(h5x::DataType mem_type, void *data, DataSpace *dspace) const
 {
     HErr res;
@@ -14,9 +14,12 @@
 #include <h5x/DataType.hpp>
 #include <h5x/LocID.hpp>
 #include <h5x/Hydra.hpp>
+#include <h5x/MappedData.hpp>
 
 namespace h5x {
 
+class ChunkStream;
+
 class DataSet : public LocID {
 
 public:
@@ -38,6 +41,17 @@ public:
     void read(TypeId dtype, void *data, const Selection &fileSel, const Selection &memSel) const;
     void write(TypeId dtype, const void *data, const Selection &fileSel, const Selection &memSel);
 
+    // count rows (first dimension) from row start in one transfer;
+    // data is a row-major block of count rows
+    void readRows(TypeId dtype, void *data, ndsize_t start, ndsize_t count) const;
+    void writeRows(TypeId dtype, const void *data, ndsize_t start, ndsize_t count);
+
+    // the given rows in one transfer, data holds them in the given
+    // order; unordered rows (not for strings) go through a buffer,
+    // rows to write must be unique
+    void readRows(TypeId dtype, void *data, const std::vector<ndsize_t> &rows) const;
+    void writeRows(TypeId dtype, const void *data, const std::vector<ndsize_t> &rows);
+
     template<typename T> void read(T &value, bool resize = false) const;
     template<typename T> void read(T &value, const Selection &fileSel, bool resize = false) const;
     template<typename T> void read(T &value, const Selection &fileSel, const Selection &memSel) const;
@@ -46,6 +60,14 @@ public:
     template<typename T> void write(const T &value, const Selection &fileSel);
     template<typename T> void write(const T &value, const Selection &fileSel, const Selection &memSel);
 
+    // all values, mapped from the file where possible (see MappedRegion)
+    // and read otherwise; T must be the native type of the dataset
+    template<typename T> DataView<T> mapReadOnly() const;
+
+    // walk all rows in chunk-aligned blocks, read ahead on a helper
+    // thread (include h5x/ChunkStream.hpp)
+    ChunkStream chunks(TypeId dtype, ndsize_t blockRows = 0) const;
+
     static NDSize guessChunking(NDSize dims, TypeId dtype);
 
     static NDSize guessChunking(NDSize dims, size_t element_size);
@@ -54,6 +76,9 @@ public:
     Selection createSelection() const;
     NDSize size() const;
 
+    // catch up with a SWMR writer: new extent and data (H5Drefresh)
+    void refresh();
+
     void vlenReclaim(h5x::DataType mem_type, void *data, DataSpace *dspace = nullptr) const;
 
     TypeId dataType(void) const;
@@ -78,7 +103,7 @@ template<typename T> void DataSet::read(T &value, bool resize) const
         hydra.resize(dims);
     }
 
-    DataType dtype = hydra.element_data_type();
+    TypeId dtype = hydra.element_data_type();
     NDSize size = hydra.shape();
     read(dtype, size, hydra.data());
 }
@@ -116,7 +141,7 @@ template<typename T> void DataSet::read(T &value, const Selection &fileSel, cons
 {
     Hydra<T> hydra(value);
 
-    DataType dtype = hydra.element_data_type();
+    TypeId dtype = hydra.element_data_type();
     this->read(dtype, hydra.data(), fileSel, memSel);
 }
 
@@ -132,7 +157,7 @@ template<typename T> void DataSet::write(const T &value)
 {
     const Hydra<const T> hydra(value);
 
-    DataType dtype = hydra.element_data_type();
+    TypeId dtype = hydra.element_data_type();
     NDSize size = hydra.shape();
     write(dtype, size, hydra.data());
 }
@@ -160,11 +185,19 @@ template<typename T> void DataSet::write(const T &value, const Selection &fileSe
 template<typename T> void DataSet::write(const T &value, const Selection &fileSel, const Selection &memSel)
 {
     const Hydra<const T> hydra(value);
-    DataType dtype = hydra.element_data_type();
+    TypeId dtype = hydra.element_data_type();
 
     this->write(dtype, hydra.data(), fileSel, memSel);
 }
 
+/* ************************************************************************* */
+
+template<typename T> DataView<T> DataSet::mapReadOnly() const
+{
+    static_assert(to_type_id<T>::is_valid, "DataView cannot handle this type");
+    return DataView<T>(MappedRegion::map(*this, to_type_id<T>::value));
+}
+
 
 } // namespace h5x
 
@@ -0,0 +1,88 @@
+#include <h5x/DataSetOptions.hpp>
+#include <h5x/DataSet.hpp>
+
+namespace h5x {
+
+static void requireFilter(H5Z_filter_t filter, const std::string &name) {
+    HTri avail = H5Zfilter_avail(filter);
+    if (!avail.check("DataSetOptions: H5Zfilter_avail failed")) {
+        throw H5Exception("DataSetOptions: " + name + " filter not available");
+    }
+}
+
+
+HId DataSetOptions::creationList(const DataType &fileType, const NDSize &size) const {
+    HId dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    dcpl.check("Could not create data creation plist");
+
+    NDSize chunkSize = chunks;
+    if (!chunkSize && guessChunks && size) {
+        chunkSize = DataSet::guessChunking(size, fileType.size());
+    }
+
+    if (chunkSize) {
+        int rank = static_cast<int>(chunkSize.size());
+        HErr res = H5Pset_chunk(dcpl.h5id(), rank, chunkSize.data());
+        res.check("Could not set chunk size on data set creation plist");
+    } else if (filtered()) {
+        throw H5Exception("DataSetOptions: filters need a chunked layout");
+    }
+
+    // the order matters: scale-offset and n-bit work on the values,
+    // shuffle on their bytes, then deflate
+    if (scaleOffset >= 0) {
+        H5T_class_t cls = H5Tget_class(fileType.h5id());
+        H5Z_SO_scale_type_t st = cls == H5T_FLOAT ? H5Z_SO_FLOAT_DSCALE : H5Z_SO_INT;
+        int factor = cls == H5T_FLOAT ? scaleOffset : (scaleOffset == 0 ? H5Z_SO_INT_MINBITS_DEFAULT : scaleOffset);
+
+        requireFilter(H5Z_FILTER_SCALEOFFSET, "scale-offset");
+        HErr res = H5Pset_scaleoffset(dcpl.h5id(), st, factor);
+        res.check("Could not set scale-offset filter");
+    }
+
+    if (nbit) {
+        requireFilter(H5Z_FILTER_NBIT, "n-bit");
+        HErr res = H5Pset_nbit(dcpl.h5id());
+        res.check("Could not set n-bit filter");
+    }
+
+    if (shuffle) {
+        requireFilter(H5Z_FILTER_SHUFFLE, "shuffle");
+        HErr res = H5Pset_shuffle(dcpl.h5id());
+        res.check("Could not set shuffle filter");
+    }
+
+    if (deflate >= 0) {
+        requireFilter(H5Z_FILTER_DEFLATE, "deflate");
+        HErr res = H5Pset_deflate(dcpl.h5id(), static_cast<unsigned>(deflate));
+        res.check("Could not set deflate filter");
+    }
+
+    if (fill) {
+        const double value = *fill;
+        HErr res = H5Pset_fill_value(dcpl.h5id(), H5T_NATIVE_DOUBLE, &value);
+        res.check("Could not set fill value");
+    }
+
+    if (alloc != AllocTime::Default) {
+        H5D_alloc_time_t at = alloc == AllocTime::Early ? H5D_ALLOC_TIME_EARLY :
+                              alloc == AllocTime::Late ? H5D_ALLOC_TIME_LATE : H5D_ALLOC_TIME_INCR;
+        HErr res = H5Pset_alloc_time(dcpl.h5id(), at);
+        res.check("Could not set allocation time");
+    }
+
+    return dcpl;
+}
+
+
+HId accessList(const ChunkCache &cache) {
+    HId dapl = H5Pcreate(H5P_DATASET_ACCESS);
+    dapl.check("Could not create data access plist");
+
+    HErr res = H5Pset_chunk_cache(dapl.h5id(), cache.slots, cache.bytes, cache.w0);
+    res.check("Could not set chunk cache");
+
+    return dapl;
+}
+
+} // h5x::
@@ -0,0 +1,83 @@
+#ifndef H5X_DATASETOPTIONS_H
+#define H5X_DATASETOPTIONS_H
+
+#include <h5x/HId.hpp>
+#include <h5x/DataType.hpp>
+#include <h5x/NDSize.hpp>
+
+#include <boost/optional.hpp>
+
+namespace h5x {
+
+/**
+ * When the storage of a dataset is allocated (H5Pset_alloc_time);
+ * Default leaves it to the library (late for contiguous, incremental
+ * for chunked datasets).
+ */
+enum class AllocTime {
+    Default,
+    Early,
+    Incremental,
+    Late
+};
+
+/**
+ * Raw data chunk cache of an open dataset (H5Pset_chunk_cache).
+ * The library default is 1 MiB and 521 slots, which is too small
+ * once a chunk row is larger than that or many chunks are touched.
+ */
+struct ChunkCache {
+    ChunkCache(size_t bytes = 1024 * 1024, size_t slots = 521, double w0 = 0.75)
+        : bytes(bytes), slots(slots), w0(w0) { }
+
+    size_t bytes;  // total size of the cache
+    size_t slots;  // hash table slots, ideally a prime ~100x the chunks that fit
+    double w0;     // preemption policy, 1 evicts fully read/written chunks first
+};
+
+/**
+ * How a dataset is laid out on disk: chunking, the filter pipeline,
+ * fill value and allocation time, plus the chunk cache to use while
+ * the dataset is open. Filters need a chunked layout.
+ */
+struct DataSetOptions {
+    DataSetOptions()
+        : guessChunks(true), maxSizeUnlimited(true), shuffle(false), deflate(-1),
+          nbit(false), scaleOffset(-1), alloc(AllocTime::Default) { }
+
+    // shuffle + deflate, a good default for float data
+    static DataSetOptions compressed(int level = 4) {
+        DataSetOptions opts;
+        opts.shuffle = true;
+        opts.deflate = level;
+        return opts;
+    }
+
+    NDSize maxsize;          // empty: see maxSizeUnlimited
+    NDSize chunks;           // empty: see guessChunks
+    bool guessChunks;
+    bool maxSizeUnlimited;
+
+    bool shuffle;            // byte shuffle, helps deflate a lot for floats
+    int deflate;             // gzip level 0-9, -1 disables
+    bool nbit;               // n-bit packing (for types with reduced precision)
+    int scaleOffset;         // lossy: decimal digits kept (floats),
+                             // bits (ints, 0 = automatic); -1 disables
+
+    boost::optional<double> fill; // converted to the type of the dataset
+    AllocTime alloc;
+
+    boost::optional<ChunkCache> cache;
+
+    bool filtered() const { return shuffle || deflate >= 0 || nbit || scaleOffset >= 0; }
+
+    // the dataset creation property list for a dataset of fileType and size
+    HId creationList(const DataType &fileType, const NDSize &size) const;
+};
+
+// the dataset access property list for cache
+HId accessList(const ChunkCache &cache);
+
+} // h5x::
+
+#endif
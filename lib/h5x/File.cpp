@@ -3,9 +3,46 @@
 
 #include <sys/stat.h>
 
+#include <stdexcept>
+
 namespace h5x {
 
 
+// SWMR needs the latest file format
+static HId swmrAccess() {
+    HId fapl = H5Pcreate(H5P_FILE_ACCESS);
+    fapl.check("Could not create file access plist");
+
+    HErr res = H5Pset_libver_bounds(fapl.h5id(), H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    res.check("Could not set library version bounds");
+
+    return fapl;
+}
+
+// a file written in SWMR mode stays marked as open for writing if the
+// writer crashed; SWMR readers can still open it, nobody else can
+static File openMarked(const std::string &path) {
+    HId fapl = swmrAccess();
+    File fd;
+
+    H5E_BEGIN_TRY {
+        fd = H5Fopen(path.c_str(), H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, fapl.h5id());
+    } H5E_END_TRY;
+
+    return fd;
+}
+
+static File openExisting(const std::string &path, unsigned int flags, hid_t fapl) {
+    File fd = H5Fopen(path.c_str(), flags, fapl);
+
+    if (!fd.isValid() && openMarked(path).isValid()) {
+        throw std::runtime_error(path + " is marked as open by an SWMR writer; if none is running "
+                                 "any more, clear the mark with: h5clear -s " + path);
+    }
+
+    return fd;
+}
+
 File File::open(const std::string &path, const std::string &mode) {
 
     if (mode.empty()) {
@@ -13,24 +50,45 @@ File File::open(const std::string &path, const std::string &mode) {
     }
 
     const char *p = mode.c_str(); //null-terminated
+    const bool swmr = mode.find('s') != std::string::npos;
+
+    HId fapl;
+    if (swmr) {
+        fapl = swmrAccess();
+    }
+
+    const hid_t ap = swmr ? fapl.h5id() : H5P_DEFAULT;
 
     File fd;
     if (p[0] == 'r') {
         unsigned int flags = p[1] == '+' ? H5F_ACC_RDWR : H5F_ACC_RDONLY;
-        fd = H5Fopen(path.c_str(), flags, H5P_DEFAULT);
+        if (flags == H5F_ACC_RDWR) {
+            fd = openExisting(path, flags, ap);
+        } else if (swmr) {
+            fd = H5Fopen(path.c_str(), flags | H5F_ACC_SWMR_READ, ap);
+        } else {
+            H5E_BEGIN_TRY {
+                fd = H5Fopen(path.c_str(), flags, ap);
+            } H5E_END_TRY;
+
+            // read what the crashed writer flushed, or report the first error
+            if (!fd.isValid() && !(fd = openMarked(path)).isValid()) {
+                fd = H5Fopen(path.c_str(), flags, ap);
+            }
+        }
     } else if (p[0] == 'w') {
-        fd = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        fd = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, ap);
     } else if (p[0] == 'a') {
         struct stat statbuf;
         int res = lstat(path.c_str(), &statbuf);
         if (res != 0) {
             if (errno == ENOENT) {
-                fd = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+                fd = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, ap);
             } else {
                 throw std::runtime_error("lstate failed");
             }
         } else {
-            fd = H5Fopen(path.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+            fd = openExisting(path, H5F_ACC_RDWR, ap);
         }
     } else {
         throw std::invalid_argument("invalid open mode");
@@ -38,4 +96,25 @@ File File::open(const std::string &path, const std::string &mode) {
 
     return fd;
 }
-}
\ No newline at end of file
+
+
+void File::flush() const {
+    HErr res = H5Fflush(hid, H5F_SCOPE_GLOBAL);
+    res.check("File::flush(): Could not flush file");
+}
+
+
+bool File::swmrCapable() const {
+    H5F_info2_t info;
+    HErr res = H5Fget_info2(hid, &info);
+    res.check("File::swmrCapable(): Could not get file info");
+    return info.super.version >= 3;
+}
+
+
+void File::startSwmr() const {
+    HErr res = H5Fstart_swmr_write(hid);
+    res.check("File::startSwmr(): Could not start SWMR writing");
+}
+
+}
@@ -24,8 +24,26 @@ public:
     File(hid_t hid) : Group(hid) {}
     File(const File &other) : Group(other) {}
 
+    // mode: "r", "r+", "w" or "a"; with an added "s" the file is
+    // single-writer/multiple-reader (SWMR) capable: "rs" follows a
+    // file that is being written (see DataSet::refresh()), the others
+    // use the latest file format so that startSwmr() can be called.
+    // A file whose SWMR writer crashed stays marked as open: "r" then
+    // reads it as "rs" would, the writable modes throw and name the
+    // fix (h5clear -s)
     static File open(const std::string &path, const std::string &mode);
 
+    // write out everything buffered by the library (H5Fflush)
+    void flush() const;
+
+    // false for files created in the older format, even if opened
+    // with "s"; the format of existing files is not upgraded
+    bool swmrCapable() const;
+
+    // let "rs" readers in; no objects or attributes can be created
+    // afterwards, only datasets extended and written
+    void startSwmr() const;
+
 };
 
 } // h5x::
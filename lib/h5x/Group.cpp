@@ -22,19 +22,20 @@ bool Group::hasObject(const std::string &name) const {
     return res.check("Group::hasObject(): H5Lexists failed");
 }
 
-bool Group::objectOfType(const std::string &name, H5O_type_t type) const {
-    H5O_info_t info;
+bool Group::objectOfType(const std::string &name, H5I_type_t type) const {
+    hid_t obj;
 
-    hid_t obj = H5Oopen(hid, name.c_str(), H5P_DEFAULT);
+    // a dangling soft link is not an error here
+    H5E_BEGIN_TRY {
+        obj = H5Oopen(hid, name.c_str(), H5P_DEFAULT);
+    } H5E_END_TRY;
 
-    if (!H5Iis_valid(obj)) {
+    if (obj < 0) {
         return false;
     }
 
-    HErr err = H5Oget_info(obj, &info);
-    err.check("Could not obtain object info");
-
-    bool res = info.type == type;
+    // the type of the handle, without H5Oget_info collecting the header
+    bool res = H5Iget_type(obj) == type;
 
     H5Oclose(obj);
     return res;
@@ -85,7 +86,30 @@ std::string Group::objectName(ndsize_t index) const {
 
 
 bool Group::hasData(const std::string &name) const {
-    return hasObject(name) && objectOfType(name, H5O_TYPE_DATASET);
+    return hasObject(name) && objectOfType(name, H5I_DATASET);
+}
+
+
+boost::optional<DataSet> Group::tryOpenData(const std::string &name) const {
+    if (!hasObject(name)) {
+        return boost::none;
+    }
+
+    hid_t obj;
+    H5E_BEGIN_TRY {
+        obj = H5Oopen(hid, name.c_str(), H5P_DEFAULT);
+    } H5E_END_TRY;
+
+    if (obj < 0) {
+        return boost::none;
+    }
+
+    if (H5Iget_type(obj) != H5I_DATASET) {
+        H5Oclose(obj);
+        return boost::none;
+    }
+
+    return DataSet(obj);
 }
 
 
@@ -112,32 +136,139 @@ DataSet Group::createData(const std::string &name,
         NDSize chunks,
         bool max_size_unlimited,
         bool guess_chunks) const
+{
+    DataSetOptions opts;
+    opts.maxsize = maxsize;
+    opts.chunks = chunks;
+    opts.maxSizeUnlimited = max_size_unlimited;
+    opts.guessChunks = guess_chunks;
+
+    return createData(name, fileType, size, opts);
+}
+
+
+DataSet Group::createData(const std::string &name,
+                          TypeId dtype,
+                          const NDSize &size,
+                          const DataSetOptions &opts) const
+{
+    h5x::DataType fileType = data_type_to_h5_filetype(dtype);
+    return createData(name, fileType, size, opts);
+}
+
+
+DataSet Group::createData(const std::string &name,
+                          const h5x::DataType &fileType,
+                          const NDSize &size,
+                          const DataSetOptions &opts) const
 {
     DataSpace space;
 
     if (size) {
-        if (maxsize) {
-            space = DataSpace::create(size, maxsize);
+        if (opts.maxsize) {
+            space = DataSpace::create(size, opts.maxsize);
         } else {
-            space = DataSpace::create(size, max_size_unlimited);
+            space = DataSpace::create(size, opts.maxSizeUnlimited);
         }
     }
 
+    HId dcpl = opts.creationList(fileType, size);
+    HId dapl;
+    if (opts.cache) {
+        dapl = accessList(*opts.cache);
+    }
+
+    DataSet ds = H5Dcreate(hid, name.c_str(), fileType.h5id(), space.h5id(), H5P_DEFAULT, dcpl.h5id(),
+                           dapl.isValid() ? dapl.h5id() : H5P_DEFAULT);
+    ds.check("Group::createData: Could not create DataSet with name " + name);
+
+    return ds;
+}
+
+
+DataSet Group::createVirtual(const std::string &name, const std::vector<VirtualSource> &sources) const
+{
+    if (sources.empty()) {
+        throw std::invalid_argument("Group::createVirtual: no sources for " + name);
+    }
+
+    DataType fileType;
+    NDSize shape;                // of a row, [0] is the total
+    std::vector<NDSize> extents; // of the sources
+    std::vector<ndsize_t> rows;
+
+    for (const VirtualSource &src : sources) {
+        HId fd = H5Fopen(src.file.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        fd.check("Group::createVirtual: could not open " + src.file);
+
+        DataSet ds = H5Dopen(fd.h5id(), src.dataset.c_str(), H5P_DEFAULT);
+        ds.check("Group::createVirtual: no " + src.dataset + " in " + src.file);
+
+        DataType dtype = H5Dget_type(ds.h5id());
+        NDSize dims = ds.size();
+
+        if (dims.size() == 0) {
+            throw std::invalid_argument("Group::createVirtual: " + src.file + ": cannot map a scalar");
+        }
+
+        if (!fileType.isValid()) {
+            fileType = dtype;
+            shape = dims;
+            shape[0] = 0;
+        } else {
+            bool same = dims.size() == shape.size() &&
+                        HTri(H5Tequal(dtype.h5id(), fileType.h5id())).check("Group::createVirtual: H5Tequal failed");
+
+            for (size_t i = 1; same && i < dims.size(); i++) {
+                same = dims[i] == shape[i];
+            }
+
+            if (!same) {
+                throw std::invalid_argument("Group::createVirtual: " + src.dataset + " in " + src.file +
+                                            " differs in type or shape");
+            }
+        }
+
+        ndsize_t n = src.rows ? *src.rows : dims[0];
+        if (n > dims[0]) {
+            throw std::invalid_argument("Group::createVirtual: " + src.file + " has fewer rows");
+        }
+
+        extents.push_back(dims);
+        rows.push_back(n);
+        shape[0] += n;
+    }
+
+    DataSpace vspace = DataSpace::create(shape, false);
+
     HId dcpl = H5Pcreate(H5P_DATASET_CREATE);
     dcpl.check("Could not create data creation plist");
 
-    if (!chunks && guess_chunks) {
-        chunks = DataSet::guessChunking(size, fileType.size());
-    }
+    ndsize_t offset = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (rows[i] == 0) {
+            continue;
+        }
+
+        NDSize count = extents[i];
+        count[0] = rows[i];
+
+        NDSize start(count.size(), 0);
+        DataSpace sspace = DataSpace::create(extents[i], false);
+        Selection(sspace).select(count, start);
+
+        start[0] = offset;
+        Selection(vspace).select(count, start);
 
-    if (chunks) {
-        int rank = static_cast<int>(chunks.size());
-        HErr res = H5Pset_chunk(dcpl.h5id(), rank, chunks.data());
-        res.check("Could not set chunk size on data set creation plist");
+        HErr res = H5Pset_virtual(dcpl.h5id(), vspace.h5id(), sources[i].file.c_str(),
+                                  sources[i].dataset.c_str(), sspace.h5id());
+        res.check("Group::createVirtual: could not map " + sources[i].file);
+
+        offset += rows[i];
     }
 
-    DataSet ds = H5Dcreate(hid, name.c_str(), fileType.h5id(), space.h5id(), H5P_DEFAULT, dcpl.h5id(), H5P_DEFAULT);
-    ds.check("Group::createData: Could not create DataSet with name " + name);
+    DataSet ds = H5Dcreate(hid, name.c_str(), fileType.h5id(), vspace.h5id(), H5P_DEFAULT, dcpl.h5id(), H5P_DEFAULT);
+    ds.check("Group::createVirtual: Could not create DataSet with name " + name);
 
     return ds;
 }
@@ -150,8 +281,16 @@ DataSet Group::openData(const std::string &name) const {
 }
 
 
+DataSet Group::openData(const std::string &name, const ChunkCache &cache) const {
+    HId dapl = accessList(cache);
+    DataSet ds = H5Dopen(hid, name.c_str(), dapl.h5id());
+    ds.check("Group::openData(): Could not open DataSet");
+    return ds;
+}
+
+
 bool Group::hasGroup(const std::string &name) const {
-    return hasObject(name) && objectOfType(name, H5O_TYPE_GROUP);
+    return hasObject(name) && objectOfType(name, H5I_GROUP);
 }
 
 
@@ -12,6 +12,7 @@
 #include <h5x/LocID.hpp>
 #include <h5x/DataSet.hpp>
 #include <h5x/DataSpace.hpp>
+#include <h5x/DataSetOptions.hpp>
 #include <h5x/Hydra.hpp>
 
 #include <boost/optional.hpp>
@@ -21,6 +22,13 @@
 
 namespace h5x {
 
+// a dataset in another file, mapped into a virtual dataset
+struct VirtualSource {
+    std::string file;
+    std::string dataset;
+    boost::optional<ndsize_t> rows; // the first rows only, default all
+};
+
 class Group : public LocID {
 
 public:
@@ -45,11 +53,31 @@ public:
             const NDSize &size, const NDSize &maxsize = {}, NDSize chunks = {},
             bool maxSizeUnlimited = true, bool guessChunks = true) const;
 
+    DataSet createData(const std::string &name, TypeId dtype,
+            const NDSize &size, const DataSetOptions &opts) const;
+
+    DataSet createData(const std::string &name, const DataType &fileType,
+            const NDSize &size, const DataSetOptions &opts) const;
+
+    // the sources one after another along the first dimension, as a
+    // virtual dataset (H5Pset_virtual): nothing is copied, reads go to
+    // the source files. All sources need the same type and the same
+    // extent apart from the first dimension; file names are stored as
+    // given, relative ones are found from the directory of this file
+    DataSet createVirtual(const std::string &name, const std::vector<VirtualSource> &sources) const;
+
     DataSet openData(const std::string &name) const;
+    DataSet openData(const std::string &name, const ChunkCache &cache) const;
+
+    // hasData() and openData() in one lookup, none if there is no
+    // dataset name (also if name is some other object)
+    boost::optional<DataSet> tryOpenData(const std::string &name) const;
     void removeData(const std::string &name);
 
+    // opts only apply if the dataset is created
     template<typename T>
-    void setData(const std::string &name, const T &value);
+    void setData(const std::string &name, const T &value,
+                 const DataSetOptions &opts = DataSetOptions());
     template<typename T>
     bool getData(const std::string &name, T &value) const;
 
@@ -67,7 +95,7 @@ public:
 
 private:
 
-    bool objectOfType(const std::string &name, H5O_type_t type) const;
+    bool objectOfType(const std::string &name, H5I_type_t type) const;
 
 }; // group Group
 
@@ -75,17 +103,20 @@ private:
 //template functions
 
 template<typename T>
-void Group::setData(const std::string &name, const T &value)
+void Group::setData(const std::string &name, const T &value, const DataSetOptions &opts)
 {
     const Hydra<const T> hydra(value);
     TypeId dtype = hydra.element_data_type();
     NDSize shape = hydra.shape();
 
+    boost::optional<DataSet> existing = tryOpenData(name);
+
     DataSet ds;
-    if (!hasData(name)) {
-        ds = createData(name, dtype, shape);
+    if (!existing) {
+        ds = createData(name, dtype, shape, opts);
     } else {
-        ds = openData(name);
+        // the chunk cache is a property of the handle
+        ds = opts.cache ? openData(name, *opts.cache) : *existing;
         ds.setExtent(shape);
     }
 
@@ -96,12 +127,13 @@ void Group::setData(const std::string &name, const T &value)
 template<typename T>
 bool Group::getData(const std::string &name, T &value) const
 {
-    if (!hasData(name)) {
+    boost::optional<DataSet> found = tryOpenData(name);
+    if (!found) {
         return false;
     }
 
     Hydra<T> hydra(value);
-    DataSet ds = openData(name);
+    DataSet ds = *found;
 
     TypeId dtype = hydra.element_data_type();
     NDSize shape = ds.size();
@@ -0,0 +1,80 @@
+#include <h5x/HandleCache.hpp>
+
+namespace h5x {
+
+HandleCache::HandleCache(const Group &root, size_t capacity)
+    : root(root), datasets(capacity), attrs(capacity), nhits(0), nmisses(0) {
+
+    if (capacity == 0) {
+        throw std::invalid_argument("HandleCache: capacity must not be 0");
+    }
+}
+
+
+boost::optional<DataSet> HandleCache::tryData(const std::string &path) {
+    if (DataSet *ds = datasets.find(path)) {
+        nhits++;
+        return *ds;
+    }
+
+    nmisses++;
+    boost::optional<DataSet> ds = root.tryOpenData(path);
+    if (ds) {
+        datasets.put(path, *ds);
+    }
+
+    return ds;
+}
+
+
+DataSet HandleCache::data(const std::string &path) {
+    boost::optional<DataSet> ds = tryData(path);
+    if (!ds) {
+        throw H5Exception("HandleCache: no DataSet " + path);
+    }
+    return *ds;
+}
+
+
+boost::optional<Attribute> HandleCache::tryAttr(const std::string &path, const std::string &name) {
+    const std::string key = attrKey(path, name);
+
+    if (Attribute *attr = attrs.find(key)) {
+        nhits++;
+        return *attr;
+    }
+
+    nmisses++;
+
+    HTri exists = H5Aexists_by_name(root.h5id(), path.c_str(), name.c_str(), H5P_DEFAULT);
+    if (!exists.check("HandleCache: H5Aexists_by_name failed for " + path)) {
+        return boost::none;
+    }
+
+    Attribute attr = H5Aopen_by_name(root.h5id(), path.c_str(), name.c_str(), H5P_DEFAULT, H5P_DEFAULT);
+    attr.check("HandleCache: could not open attribute " + name + " of " + path);
+
+    attrs.put(key, attr);
+    return attr;
+}
+
+
+void HandleCache::evict(const std::string &path) {
+    datasets.erase(path);
+    attrs.erasePrefix(attrKey(path, ""));
+}
+
+
+void HandleCache::clear() {
+    datasets.clear();
+    attrs.clear();
+}
+
+
+LocID HandleCache::openObject(const std::string &path) const {
+    LocID obj = H5Oopen(root.h5id(), path.c_str(), H5P_DEFAULT);
+    obj.check("HandleCache: could not open " + path);
+    return obj;
+}
+
+} // h5x::
@@ -0,0 +1,160 @@
+#ifndef H5X_HANDLECACHE_H
+#define H5X_HANDLECACHE_H
+
+#include <h5x/Group.hpp>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace h5x {
+
+/**
+ * Open dataset and attribute handles below one group (usually a
+ * file), looked up by path; only misses go to the library. Once there
+ * are more than capacity handles of a kind the least recently used is
+ * closed.
+ *
+ * The cache does not notice objects that are removed or replaced
+ * around it, evict() those. Cached handles keep the file open (its
+ * close is deferred) until the cache is cleared or destroyed.
+ */
+class HandleCache {
+public:
+    explicit HandleCache(const Group &root, size_t capacity = 64);
+
+    boost::optional<DataSet> tryData(const std::string &path);
+    DataSet data(const std::string &path);
+
+    // attribute name of the object at path ("." for the root)
+    boost::optional<Attribute> tryAttr(const std::string &path, const std::string &name);
+
+    template<typename T>
+    bool getAttr(const std::string &path, const std::string &name, T &value);
+
+    // through the cached handle if the attribute exists with the same
+    // extent and type class (string or not), else like LocID::setAttr()
+    template<typename T>
+    void setAttr(const std::string &path, const std::string &name, const T &value);
+
+    // the dataset at path and all attributes of the object at path
+    void evict(const std::string &path);
+    void clear();
+
+    size_t hits() const { return nhits; }
+    size_t misses() const { return nmisses; }
+
+private:
+    template<typename V>
+    class Lru {
+    public:
+        explicit Lru(size_t capacity) : capacity(capacity) { }
+
+        V *find(const std::string &key) {
+            auto it = index.find(key);
+            if (it == index.end()) {
+                return nullptr;
+            }
+
+            entries.splice(entries.begin(), entries, it->second);
+            return &it->second->second;
+        }
+
+        void put(const std::string &key, const V &value) {
+            erase(key);
+            entries.emplace_front(key, value);
+            index[key] = entries.begin();
+
+            if (entries.size() > capacity) {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+        }
+
+        void erase(const std::string &key) {
+            auto it = index.find(key);
+            if (it != index.end()) {
+                entries.erase(it->second);
+                index.erase(it);
+            }
+        }
+
+        void erasePrefix(const std::string &prefix) {
+            for (auto it = entries.begin(); it != entries.end();) {
+                if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                    index.erase(it->first);
+                    it = entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        void clear() {
+            index.clear();
+            entries.clear();
+        }
+
+    private:
+        typedef std::list<std::pair<std::string, V>> list_type;
+
+        size_t capacity;
+        list_type entries; // most recently used first
+        std::unordered_map<std::string, typename list_type::iterator> index;
+    };
+
+    static std::string attrKey(const std::string &path, const std::string &name) {
+        return path + '\0' + name;
+    }
+
+    LocID openObject(const std::string &path) const;
+
+    Group root;
+    Lru<DataSet> datasets;
+    Lru<Attribute> attrs;
+    size_t nhits;
+    size_t nmisses;
+};
+
+
+template<typename T>
+bool HandleCache::getAttr(const std::string &path, const std::string &name, T &value)
+{
+    boost::optional<Attribute> attr = tryAttr(path, name);
+    if (!attr) {
+        return false;
+    }
+
+    Hydra<T> hydra(value);
+
+    NDSize dims = attr->extent();
+    hydra.resize(dims);
+
+    DataType memType = data_type_to_h5_memtype(hydra.element_data_type());
+    attr->read(memType, dims, hydra.data());
+
+    return true;
+}
+
+
+template<typename T>
+void HandleCache::setAttr(const std::string &path, const std::string &name, const T &value)
+{
+    const Hydra<const T> hydra(value);
+    const TypeId dtype = hydra.element_data_type();
+    const NDSize shape = hydra.shape();
+
+    boost::optional<Attribute> attr = tryAttr(path, name);
+    if (attr && attr->extent() == shape && attr->isString() == (dtype == TypeId::String)) {
+        attr->write(data_type_to_h5_memtype(dtype), shape, hydra.data());
+        return;
+    }
+
+    attrs.erase(attrKey(path, name));
+    openObject(path).setAttr(name, value);
+}
+
+} // h5x::
+
+#endif
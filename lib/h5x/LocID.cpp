@@ -10,6 +10,8 @@
 
 #include <h5x/LocID.hpp>
 
+#include <map>
+
 namespace h5x {
 
 LocID::LocID() : HId() {}
@@ -47,6 +49,48 @@ Attribute LocID::createAttr(const std::string &name, h5x::DataType fileType, con
 }
 
 
+void LocID::setAttrs(const AttrMap &attrs) const {
+    std::map<TypeId, std::pair<DataType, DataType>> types; // file, memory
+
+    for (const auto &kv : attrs.values) {
+        const std::string &name = kv.first;
+        const AttrMap::Value &v = kv.second;
+
+        auto t = types.find(v.dtype);
+        if (t == types.end()) {
+            auto ft = std::make_pair(data_type_to_h5_filetype(v.dtype), data_type_to_h5_memtype(v.dtype));
+            t = types.insert(std::make_pair(v.dtype, ft)).first;
+        }
+
+        // one lookup instead of H5Aexists + H5Aopen
+        hid_t aid;
+        H5E_BEGIN_TRY {
+            aid = H5Aopen(hid, name.c_str(), H5P_DEFAULT);
+        } H5E_END_TRY;
+
+        Attribute attr;
+        if (aid >= 0) {
+            attr = Attribute(aid);
+
+            if (attr.extent() != v.shape || attr.isString() != (v.dtype == TypeId::String)) {
+                attr = Attribute();
+                removeAttr(name);
+            }
+        }
+
+        if (!attr.isValid()) {
+            attr = createAttr(name, t->second.first, DataSpace::create(v.shape, false));
+        }
+
+        if (v.dtype == TypeId::String) {
+            attr.write(t->second.second, v.shape, v.strings.data());
+        } else {
+            attr.write(t->second.second, v.shape, static_cast<const void *>(v.bytes.data()));
+        }
+    }
+}
+
+
 void LocID::deleteLink(std::string name, hid_t plist) {
     HErr res = H5Ldelete(hid, name.c_str(), plist);
     res.check("LocIDL::deleteLink: Could not delete link: " + name);
@@ -16,8 +16,47 @@
 #include <h5x/Hydra.hpp>
 #include <h5x/DataType.hpp>
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace h5x {
 
+/**
+ * Attribute values of mixed types, set together with LocID::setAttrs().
+ * The values are copied.
+ */
+class AttrMap {
+public:
+    template <typename T>
+    AttrMap &set(const std::string &name, const T &value);
+
+    bool empty() const { return values.empty(); }
+    size_t size() const { return values.size(); }
+
+private:
+    friend class LocID;
+
+    struct Value {
+        TypeId dtype;
+        NDSize shape;
+        std::vector<char> bytes;
+        std::vector<std::string> strings; // for TypeId::String
+    };
+
+    static void store(Value &v, const std::string *data, size_t n) {
+        v.strings.assign(data, data + n);
+    }
+
+    template <typename E>
+    static void store(Value &v, const E *data, size_t n) {
+        const char *p = reinterpret_cast<const char *>(data);
+        v.bytes.assign(p, p + n * sizeof(E));
+    }
+
+    std::map<std::string, Value> values;
+};
+
 class LocID : public HId {
 public:
     LocID();
@@ -37,6 +76,10 @@ public:
     template <typename T>
     bool getAttr(const std::string &name, T &value) const;
 
+    // all of attrs with one lookup each and the types converted once;
+    // one that changes shape or between string and number is recreated
+    void setAttrs(const AttrMap &attrs) const;
+
     void deleteLink(std::string name, hid_t plist = H5L_SAME_LOC);
 
 private:
@@ -47,6 +90,20 @@ private:
 };
 
 
+template <typename T> AttrMap &AttrMap::set(const std::string &name, const T &value)
+{
+    const Hydra<const T> hydra(value);
+
+    Value v;
+    v.dtype = hydra.element_data_type();
+    v.shape = hydra.shape();
+    store(v, hydra.data(), check::fits_in_size_t(v.shape.nelms(), "AttrMap: value too large"));
+
+    values[name] = std::move(v);
+    return *this;
+}
+
+
 template<typename T> void LocID::setAttr(const std::string &name, const T &value) const
 {
     typedef Hydra<const T> hydra_t;
@@ -59,7 +116,13 @@ template<typename T> void LocID::setAttr(const std::string &name, const T &value
 
     if (hasAttr(name)) {
         attr = openAttr(name);
-    } else {
+        if (attr.extent() != shape || attr.isString() != (dtype == TypeId::String)) {
+            attr = Attribute();
+            removeAttr(name);
+        }
+    }
+
+    if (!attr.isValid()) {
         DataType fileType = data_type_to_h5_filetype(dtype);
         DataSpace fileSpace = DataSpace::create(shape, false);
         attr = createAttr(name, fileType, fileSpace);
@@ -0,0 +1,138 @@
+#include <h5x/MappedData.hpp>
+#include <h5x/DataSet.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace h5x {
+
+// the absolute file offset of the raw data of ds, if it can be mapped as dtype;
+// id is the device and inode of the file the library has open
+static bool mappableOffset(const DataSet &ds, TypeId dtype, std::string &path, off_t &offset, struct stat &id) {
+    HId dcpl = H5Dget_create_plist(ds.h5id());
+    dcpl.check("MappedRegion: could not get creation plist");
+
+    if (H5Pget_layout(dcpl.h5id()) != H5D_CONTIGUOUS || H5Pget_external_count(dcpl.h5id()) != 0) {
+        return false;
+    }
+
+    HId ftype = H5Dget_type(ds.h5id());
+    ftype.check("MappedRegion: could not get data type");
+
+    DataType memType = data_type_to_h5_memtype(dtype);
+    if (!HTri(H5Tequal(ftype.h5id(), memType.h5id())).check("MappedRegion: H5Tequal failed")) {
+        return false;
+    }
+
+    HId file = H5Iget_file_id(ds.h5id());
+    file.check("MappedRegion: could not get file");
+
+    HId fapl = H5Fget_access_plist(file.h5id());
+    fapl.check("MappedRegion: could not get file access plist");
+
+    if (H5Pget_driver(fapl.h5id()) != H5FD_SEC2) {
+        return false;
+    }
+
+    // raw data written through this handle may still be in the library's cache
+    unsigned intent = 0;
+    HErr res = H5Fget_intent(file.h5id(), &intent);
+    res.check("MappedRegion: could not get file intent");
+
+    if (intent & H5F_ACC_RDWR) {
+        res = H5Fflush(file.h5id(), H5F_SCOPE_LOCAL);
+        res.check("MappedRegion: could not flush file");
+    }
+
+    haddr_t addr = H5Dget_offset(ds.h5id());
+    if (addr == HADDR_UNDEF) {
+        return false; // no storage allocated yet
+    }
+
+    // H5Dget_offset already accounts for a user block
+    offset = static_cast<off_t>(addr);
+    if (offset % static_cast<off_t>(data_type_to_size(dtype)) != 0) {
+        return false;
+    }
+
+    ssize_t len = H5Fget_name(file.h5id(), nullptr, 0);
+    if (len < 0) {
+        throw H5Exception("MappedRegion: could not get file name");
+    }
+
+    path.resize(static_cast<size_t>(len) + 1);
+    if (H5Fget_name(file.h5id(), &path[0], path.size()) != len) {
+        throw H5Exception("MappedRegion: could not get file name");
+    }
+    path.resize(static_cast<size_t>(len));
+
+    // the name may by now refer to another file (renamed or replaced)
+    int *handle = nullptr;
+    res = H5Fget_vfd_handle(file.h5id(), fapl.h5id(), reinterpret_cast<void **>(&handle));
+    res.check("MappedRegion: could not get file handle");
+
+    return handle != nullptr && fstat(*handle, &id) == 0;
+}
+
+
+std::shared_ptr<const MappedRegion> MappedRegion::map(const DataSet &ds, TypeId dtype) {
+    if (dtype == TypeId::String || dtype == TypeId::Nothing) {
+        throw std::invalid_argument("MappedRegion: cannot map strings");
+    }
+
+    std::shared_ptr<MappedRegion> region(new MappedRegion(dtype, ds.size()));
+
+    const size_t bytes = check::fits_in_size_t(region->dims.nelms() * data_type_to_size(dtype),
+                                               "MappedRegion: data too big for memory");
+    if (bytes == 0) {
+        return region;
+    }
+
+    std::string path;
+    off_t offset;
+    struct stat id;
+
+    if (mappableOffset(ds, dtype, path, offset, id)) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_dev == id.st_dev && st.st_ino == id.st_ino &&
+            offset + static_cast<off_t>(bytes) <= st.st_size) {
+            const off_t page = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+            const off_t start = offset - offset % page;
+            const size_t length = bytes + static_cast<size_t>(offset - start);
+
+            void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, start);
+            if (base != MAP_FAILED) {
+                region->base = base;
+                region->length = length;
+                region->ptr = static_cast<const char *>(base) + (offset - start);
+            }
+        }
+
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    if (region->base == nullptr) {
+        region->buffer.resize(bytes);
+        ds.read(dtype, region->dims, region->buffer.data());
+        region->ptr = region->buffer.data();
+    }
+
+    return region;
+}
+
+
+MappedRegion::~MappedRegion() {
+    if (base != nullptr) {
+        munmap(base, length);
+    }
+}
+
+} // h5x::
@@ -0,0 +1,84 @@
+#ifndef H5X_MAPPEDDATA_H
+#define H5X_MAPPEDDATA_H
+
+#include <h5x/NDSize.hpp>
+#include <h5x/TypeId.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace h5x {
+
+class DataSet;
+
+/**
+ * The values of a whole dataset in memory, either the file region of
+ * its raw data mapped read-only (no copy, pages are loaded on first
+ * access) or, where that is not possible, a buffer it was read into.
+ *
+ * Mapping needs a contiguous (thus unfiltered) dataset with allocated
+ * storage in a file of the default (sec2) driver, whose type on disk
+ * is the native memory type, at an offset aligned for it. The mapping
+ * stays valid after the dataset and file are closed, but reflects
+ * later changes to the file by other writers.
+ */
+class MappedRegion {
+public:
+    static std::shared_ptr<const MappedRegion> map(const DataSet &ds, TypeId dtype);
+
+    ~MappedRegion();
+
+    MappedRegion(const MappedRegion &) = delete;
+    MappedRegion &operator=(const MappedRegion &) = delete;
+
+    const void *data() const { return ptr; }
+    const NDSize &shape() const { return dims; }
+    TypeId type() const { return dtype; }
+
+    // false if the data was read into a buffer
+    bool mapped() const { return base != nullptr; }
+
+private:
+    MappedRegion(TypeId dtype, const NDSize &dims)
+        : dtype(dtype), dims(dims), base(nullptr), length(0), ptr(nullptr) { }
+
+    TypeId dtype;
+    NDSize dims;
+
+    void *base;       // of the mapping, page aligned
+    size_t length;
+    const void *ptr;  // the first value
+
+    std::vector<char> buffer;
+};
+
+
+/**
+ * A typed, read-only view of a MappedRegion in row-major order.
+ */
+template<typename T>
+class DataView {
+public:
+    typedef const T *const_iterator;
+
+    DataView() { }
+    explicit DataView(std::shared_ptr<const MappedRegion> region) : region(std::move(region)) { }
+
+    const T *data() const { return region ? static_cast<const T *>(region->data()) : nullptr; }
+    NDSize shape() const { return region ? region->shape() : NDSize(); }
+    size_t size() const { return region ? static_cast<size_t>(region->shape().nelms()) : 0; }
+    bool empty() const { return size() == 0; }
+    bool mapped() const { return region && region->mapped(); }
+
+    const T &operator[](size_t i) const { return data()[i]; }
+
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+
+private:
+    std::shared_ptr<const MappedRegion> region;
+};
+
+} // h5x::
+
+#endif
@@ -27,6 +27,73 @@ void Selection::select(const NDSize &count, const NDSize &start, Mode mode)
 }
 
 
+void Selection::select(const NDSize &count, const NDSize &start, const NDSize &stride, const NDSize &block,
+                       Mode mode)
+{
+    H5S_seloper_t op = static_cast<H5S_seloper_t>(mode);
+    HErr status = H5Sselect_hyperslab(space.h5id(), op, start.data(), stride.data(), count.data(), block.data());
+    status.check("Selection::select(): Could not select hyperslab");
+}
+
+
+void Selection::clear()
+{
+    HErr status = H5Sselect_none(space.h5id());
+    status.check("Selection::clear(): Could not clear selection");
+}
+
+
+Selection Selection::rows(const DataSpace &space, const std::vector<ndsize_t> &rows)
+{
+    // selecting modifies a space in place, leave the caller's alone
+    DataSpace copy = H5Scopy(space.h5id());
+    copy.check("Selection::rows(): Could not copy data space");
+
+    Selection sel(copy);
+    sel.clear();
+
+    // runs of consecutive rows: (first row, length)
+    std::vector<std::pair<ndsize_t, ndsize_t>> runs;
+    for (size_t i = 0; i < rows.size(); ) {
+        size_t k = i + 1;
+        while (k < rows.size() && rows[k] == rows[k - 1] + 1) {
+            k++;
+        }
+
+        runs.emplace_back(rows[i], k - i);
+        i = k;
+    }
+
+    // every OR makes the next one more expensive, so equally spaced
+    // runs of the same length are merged into one strided hyperslab
+    NDSize dims = space.extent();
+    NDSize start(dims.size(), 0);
+    NDSize count(dims.size(), 1);
+    NDSize stride(dims.size(), 1);
+    NDSize block = dims;
+
+    for (size_t i = 0; i < runs.size(); ) {
+        size_t k = i + 1;
+        ndsize_t step = k < runs.size() ? runs[k].first - runs[i].first : 1;
+
+        while (k < runs.size() && runs[k].second == runs[i].second &&
+               runs[k].first - runs[k - 1].first == step) {
+            k++;
+        }
+
+        start[0] = runs[i].first;
+        count[0] = k - i;
+        stride[0] = k - i > 1 ? step : 1;
+        block[0] = runs[i].second;
+        sel.select(count, start, stride, block, Mode::Or);
+
+        i = k;
+    }
+
+    return sel;
+}
+
+
 NDSize Selection::size() const
 {
     size_t rank = this->rank();
@@ -15,6 +15,8 @@
 
 #include <hdf5.h>
 
+#include <vector>
+
 
 namespace h5x {
 
@@ -44,8 +46,23 @@ public:
     Selection& operator=(const Selection &other) { space = other.space; return *this; }
 
     void select(const NDSize &count, const NDSize &start, Mode mode = Mode::Set);
+    // count blocks of size block, stride apart
+    void select(const NDSize &count, const NDSize &start, const NDSize &stride, const NDSize &block,
+                Mode mode = Mode::Set);
     void offset(const NDSSize &offset);
 
+    // select nothing, e.g. before OR-ing together blocks with add()
+    void clear();
+    Selection &add(const NDSize &count, const NDSize &start) {
+        select(count, start, Mode::Or);
+        return *this;
+    }
+
+    // the union of the given (ascending) rows of the first dimension
+    // of space; runs of consecutive rows become one block, equally
+    // spaced runs of the same length one strided hyperslab
+    static Selection rows(const DataSpace &space, const std::vector<ndsize_t> &rows);
+
     DataSpace& h5space() { return space; }
     const DataSpace& h5space() const { return space; }
     bool isValid() const;
@@ -0,0 +1,191 @@
+#include <h5x/Hydra.hpp>
+#include <h5x/Group.hpp>
+
+#include <spectra.h>
+#include <rgb.h>
+
+#include <string>
+#include <vector>
+
+#ifndef HYDRA_IRIS_H
+#define HYDRA_IRIS_H
+
+namespace h5x {
+
+// [spectra x samples] float
+template<>
+class data_traits<iris::spectra> {
+public:
+
+    typedef iris::spectra      value_type;
+    typedef value_type&        reference;
+    typedef const value_type&  const_reference;
+
+    typedef float        element_type;
+    typedef float*       element_pointer;
+    typedef const float* const_element_pointer;
+
+    static TypeId data_type(const_reference val) {
+        return TypeId::Float;
+    }
+
+    static NDSize shape(const_reference value) {
+        return NDSize{value.num_spectra(), value.num_samples()};
+    }
+
+    static size_t num_elements(const_reference value) {
+        return value.num_spectra() * value.num_samples();
+    }
+
+    static const_element_pointer get_data(const_reference value) {
+        return value.data();
+    }
+
+    static element_pointer get_data(reference value) {
+        return value.data();
+    }
+
+    static void resize(reference value, const NDSize &dims) {
+        if (dims.size() != 2) {
+            throw std::domain_error("Cannot resize spectra: need [spectra x samples]");
+        }
+
+        size_t n = check::fits_in_size_t(dims[0], "Can't resize: data to big for memory");
+        size_t m = check::fits_in_size_t(dims[1], "Can't resize: data to big for memory");
+        value.resize(n, m);
+    }
+};
+
+// [samples] float
+template<>
+class data_traits<iris::spectrum> {
+public:
+
+    typedef iris::spectrum     value_type;
+    typedef value_type&        reference;
+    typedef const value_type&  const_reference;
+
+    typedef float        element_type;
+    typedef float*       element_pointer;
+    typedef const float* const_element_pointer;
+
+    static TypeId data_type(const_reference val) {
+        return TypeId::Float;
+    }
+
+    static NDSize shape(const_reference value) {
+        return NDSize{value.samples()};
+    }
+
+    static size_t num_elements(const_reference value) {
+        return value.samples();
+    }
+
+    static const_element_pointer get_data(const_reference value) {
+        return value.data();
+    }
+
+    static element_pointer get_data(reference value) {
+        return value.data();
+    }
+
+    static void resize(reference value, const NDSize &dims) {
+        if (dims.size() != 1) {
+            throw std::domain_error("Cannot change rank of spectrum");
+        }
+
+        value.resize(check::fits_in_size_t(dims[0], "Can't resize: data to big for memory"));
+    }
+};
+
+// [n x 3] float, the layout of the patches datasets
+template<>
+class data_traits<std::vector<iris::rgb>> {
+public:
+
+    static_assert(sizeof(iris::rgb) == 3 * sizeof(float), "iris::rgb must be three packed floats");
+
+    typedef std::vector<iris::rgb> value_type;
+    typedef value_type&            reference;
+    typedef const value_type&      const_reference;
+
+    typedef float        element_type;
+    typedef float*       element_pointer;
+    typedef const float* const_element_pointer;
+
+    static TypeId data_type(const_reference val) {
+        return TypeId::Float;
+    }
+
+    static NDSize shape(const_reference value) {
+        return NDSize{static_cast<ndsize_t>(value.size()), static_cast<ndsize_t>(3)};
+    }
+
+    static size_t num_elements(const_reference value) {
+        return value.size() * 3;
+    }
+
+    static const_element_pointer get_data(const_reference value) {
+        return value.empty() ? nullptr : &value.front().r;
+    }
+
+    static element_pointer get_data(reference value) {
+        return value.empty() ? nullptr : &value.front().r;
+    }
+
+    static void resize(reference value, const NDSize &dims) {
+        if (dims.size() != 2 || dims[1] != 3) {
+            throw std::domain_error("Cannot resize rgb vector: need [n x 3]");
+        }
+
+        value.resize(check::fits_in_size_t(dims[0], "Can't resize: data to big for memory"));
+    }
+};
+
+
+/* spectra with their metadata: the wavelengths as the attributes
+ * wl_start and wl_step (uint16), the names, if any, as names
+ */
+
+inline void setSpectra(Group &group, const std::string &name, const iris::spectra &spec,
+                       const DataSetOptions &opts = DataSetOptions()) {
+    group.setData(name, spec, opts);
+
+    DataSet ds = group.openData(name);
+    ds.setAttr("wl_start", spec.lambda_start());
+    ds.setAttr("wl_step", spec.lambda_step());
+
+    std::vector<std::string> ids = spec.names();
+    if (!ids.empty()) {
+        ds.setAttr("names", ids);
+    }
+}
+
+// the wavelengths of spec are kept if the dataset has none
+inline bool getSpectra(const Group &group, const std::string &name, iris::spectra &spec) {
+    if (!group.getData(name, spec)) {
+        return false;
+    }
+
+    DataSet ds = group.openData(name);
+
+    uint16_t start = spec.lambda_start();
+    uint16_t step = spec.lambda_step();
+    ds.getAttr("wl_start", start);
+    ds.getAttr("wl_step", step);
+    spec.lambda(start, step);
+
+    std::vector<std::string> ids;
+    if (ds.getAttr("names", ids)) {
+        if (ids.size() != spec.num_spectra()) {
+            throw H5Exception("getSpectra: names do not match the spectra of " + name);
+        }
+        spec.names(std::move(ids));
+    }
+
+    return true;
+}
+
+} //h5x::
+
+#endif // HYDRA_IRIS_H
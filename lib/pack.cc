@@ -0,0 +1,222 @@
+#include <pack.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace iris {
+namespace data {
+
+static const char pack_magic[8] = {'I', 'R', 'I', 'S', 'P', 'A', 'C', 'K'};
+
+// store_pack
+
+std::shared_ptr<store_pack> store_pack::open(const fs::file &path) {
+    int fd = ::open(path.path().c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        std::cerr << "[W] could not map store pack: " << path.path() << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<store_pack> pack(new store_pack(path, addr, length));
+    const char *base = static_cast<const char *>(addr);
+
+    try {
+        const size_t hlen = sizeof(pack_magic) + sizeof(uint8_t) + sizeof(uint32_t);
+
+        if (length < hlen || memcmp(base, pack_magic, sizeof(pack_magic)) != 0) {
+            throw wire_error("not a store pack");
+        }
+
+        wire_message header(base + sizeof(pack_magic), hlen - sizeof(pack_magic));
+
+        uint8_t version = header.get_u8();
+        if (version != IRIS_PACK_VERSION) {
+            throw wire_error("unsupported pack version: " + std::to_string(version));
+        }
+
+        uint32_t ilen = header.get_u32();
+        if (length - hlen < ilen) {
+            throw wire_error("truncated pack");
+        }
+
+        wire_message idx(base + hlen, ilen);
+        const char *data = base + hlen + ilen;
+        const size_t dlen = length - hlen - ilen;
+
+        uint32_t n = idx.get_u32();
+        for (uint32_t i = 0; i < n; i++) {
+            std::string name = idx.get_str();
+
+            entry e;
+            e.kind = static_cast<pack_kind>(idx.get_u8());
+            e.st.size = idx.get_u64();
+            e.st.mtime = idx.get_i64();
+
+            uint64_t offset = idx.get_u64();
+            uint64_t elen = idx.get_u64();
+
+            if (offset > dlen || dlen - offset < elen) {
+                throw wire_error("truncated pack");
+            }
+
+            e.data = data + offset;
+            e.length = static_cast<size_t>(elen);
+
+            pack->index[name] = e;
+        }
+
+    } catch (const wire_error &e) {
+        std::cerr << "[W] ignoring store pack: " << path.path() << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+
+    return pack;
+}
+
+store_pack::~store_pack() {
+    ::munmap(addr, length);
+}
+
+const store_pack::entry *store_pack::find(const std::string &path) const {
+    auto it = index.find(path);
+    return it != index.end() ? &it->second : nullptr;
+}
+
+// pack_writer
+
+void pack_writer::add(const std::string &path, pack_kind kind, const fs::file::status &st, std::string data) {
+    items.push_back(item{path, kind, st, std::move(data)});
+}
+
+std::string pack_writer::finish() const {
+    wire_message idx;
+    idx.put_u32(static_cast<uint32_t>(items.size()));
+
+    uint64_t offset = 0;
+    for (const item &i : items) {
+        idx.put_str(i.path);
+        idx.put_u8(static_cast<uint8_t>(i.kind));
+        idx.put_u64(i.st.size);
+        idx.put_i64(i.st.mtime);
+        idx.put_u64(offset);
+        idx.put_u64(i.data.size());
+        offset += i.data.size();
+    }
+
+    wire_message header;
+    header.put_bytes(pack_magic, sizeof(pack_magic));
+    header.put_u8(IRIS_PACK_VERSION);
+    header.put_u32(static_cast<uint32_t>(idx.data().size()));
+
+    std::string out = header.data() + idx.data();
+    out.reserve(out.size() + offset);
+
+    for (const item &i : items) {
+        out += i.data;
+    }
+
+    return out;
+}
+
+// directory listings
+
+std::string encode_dir(const std::vector<std::string> &names) {
+    wire_message msg;
+    msg.put_u32(static_cast<uint32_t>(names.size()));
+    for (const std::string &n : names) {
+        msg.put_str(n);
+    }
+    return msg.data();
+}
+
+std::vector<std::string> decode_dir(const store_pack::entry &e) {
+    if (e.kind != pack_kind::dir) {
+        throw wire_error("pack entry is not a directory");
+    }
+
+    wire_message msg(e.data, e.length);
+
+    // the count is not trusted, every name takes 4 bytes at least
+    std::vector<std::string> names(msg.get_count(sizeof(uint32_t)));
+    for (std::string &n : names) {
+        n = msg.get_str();
+    }
+
+    return names;
+}
+
+// spectra: u32 start, u32 step, u32 spectra, u32 samples,
+// the names, then the samples as one f32 array
+
+std::string encode_spectra(const iris::spectra &spec) {
+    wire_message msg;
+
+    msg.put_u32(spec.lambda_start());
+    msg.put_u32(spec.lambda_step());
+    msg.put_u32(static_cast<uint32_t>(spec.num_spectra()));
+    msg.put_u32(static_cast<uint32_t>(spec.num_samples()));
+
+    std::vector<std::string> names = spec.names();
+    msg.put_u32(static_cast<uint32_t>(names.size()));
+    for (const std::string &n : names) {
+        msg.put_str(n);
+    }
+
+    msg.put_bytes(spec.data(), spec.num_spectra() * spec.num_samples() * sizeof(float));
+    return msg.data();
+}
+
+iris::spectra decode_spectra(const store_pack::entry &e) {
+    if (e.kind != pack_kind::spectra) {
+        throw wire_error("pack entry is not spectral data");
+    }
+
+    wire_message msg(e.data, e.length);
+
+    uint16_t start = static_cast<uint16_t>(msg.get_u32());
+    uint16_t step = static_cast<uint16_t>(msg.get_u32());
+    uint32_t n_spectra = msg.get_u32();
+    uint32_t n_samples = msg.get_u32();
+
+    std::vector<std::string> names(msg.get_count(sizeof(uint32_t)));
+    for (std::string &n : names) {
+        n = msg.get_str();
+    }
+
+    if (n_spectra == 0 || n_samples == 0) {
+        return iris::spectra();
+    }
+
+    size_t nbytes = static_cast<size_t>(n_spectra) * n_samples * sizeof(float);
+    if (msg.remaining() != nbytes) {
+        throw wire_error("invalid spectral data in pack");
+    }
+
+    iris::spectra spec(n_spectra, n_samples, start, step);
+    msg.get_bytes(spec.data(), nbytes);
+    spec.names(std::move(names));
+
+    return spec;
+}
+
+} //iris::data::
+} //iris::
@@ -0,0 +1,102 @@
+#ifndef IRIS_PACK_H
+#define IRIS_PACK_H
+
+#include <fs.h>
+#include <wire.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace data {
+
+/* store packs
+ *
+ *  A read-only snapshot of a store in a single file, written by
+ *  'iris-store pack' and mapped into memory by the store. The store
+ *  directory stays the (writable) source of truth: an entry is only
+ *  used while the size and mtime of its source match, directory
+ *  listings while the mtime of the directory matches, anything else
+ *  is read from the tree as before. Layout:
+ *
+ *    magic "IRISPACK" + u8 format version
+ *    u32 index size
+ *    index (wire_message): u32 number of entries, and per entry
+ *      str path, u8 kind, u64 size, i64 mtime [ns] of the source,
+ *      u64 offset, u64 length (relative to the end of the index)
+ *    entry data
+ */
+
+#define IRIS_PACK_VERSION 1
+
+enum class pack_kind : uint8_t {
+    file    = 1, // the content as is
+    record  = 2, // binary record (see record.h)
+    link    = 3, // the target of a symlink
+    dir     = 4, // u32 count + str names (wire_message)
+    spectra = 5  // binary spectra, see encode_spectra()
+};
+
+class store_pack {
+public:
+    struct entry {
+        pack_kind kind;
+        fs::file::status st;
+        const char *data;
+        size_t length;
+
+        std::string content() const { return std::string(data, length); }
+    };
+
+    // nullptr (and a warning) if path is not a usable pack
+    static std::shared_ptr<store_pack> open(const fs::file &path);
+    ~store_pack();
+
+    store_pack(const store_pack &) = delete;
+    store_pack &operator=(const store_pack &) = delete;
+
+    const fs::file &location() const { return loc; }
+    size_t size() const { return index.size(); }
+
+    // nullptr if the pack has no such entry
+    const entry *find(const std::string &path) const;
+
+private:
+    store_pack(const fs::file &path, void *addr, size_t length)
+            : loc(path), addr(addr), length(length) { }
+
+private:
+    fs::file loc;
+    void *addr;
+    size_t length;
+    std::map<std::string, entry> index;
+};
+
+class pack_writer {
+public:
+    void add(const std::string &path, pack_kind kind, const fs::file::status &st, std::string data);
+    std::string finish() const;
+
+private:
+    struct item {
+        std::string path;
+        pack_kind kind;
+        fs::file::status st;
+        std::string data;
+    };
+
+    std::vector<item> items;
+};
+
+std::string encode_dir(const std::vector<std::string> &names);
+std::vector<std::string> decode_dir(const store_pack::entry &e);
+
+std::string encode_spectra(const iris::spectra &spec);
+iris::spectra decode_spectra(const store_pack::entry &e);
+
+} //iris::data::
+} //iris::
+
+#endif //IRIS_PACK_H
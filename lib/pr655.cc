@@ -88,7 +88,6 @@ pr655::response<std::string> pr655::io_cmd(const std::string &cmd) {
 
     bool is_measurement = cmd[0] == 'M';
     io.send_data(cmd);
-    io.wait(200);
 
     sleeper::rep tout = is_measurement ? 50000 : 5000;
     std::string l = io.recv_line(tout);
@@ -0,0 +1,268 @@
+#include <record.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace iris {
+namespace data {
+
+static const char record_magic[7] = {'I', 'R', 'I', 'S', 'R', 'E', 'C'};
+
+// record_reader
+
+bool record_reader::is_record(const std::string &data) {
+    return is_record(data.data(), data.size());
+}
+
+bool record_reader::is_record(const char *data, size_t n) {
+    return n >= sizeof(record_magic) && memcmp(data, record_magic, sizeof(record_magic)) == 0;
+}
+
+record_reader::record_reader(std::string data) : buf(std::move(data)) {
+    ptr = buf.data();
+    len = buf.size();
+    parse_header();
+}
+
+record_reader::record_reader(const char *data, size_t n) : ptr(data), len(n) {
+    parse_header();
+}
+
+void record_reader::parse_header() {
+
+    if (!is_record(ptr, len)) {
+        throw wire_error("not a binary record");
+    }
+
+    wire_message header(ptr + sizeof(record_magic), len - sizeof(record_magic));
+
+    uint8_t version = header.get_u8();
+    if (version != IRIS_RECORD_VERSION) {
+        throw wire_error("unsupported record version: " + std::to_string(version));
+    }
+
+    rtype = static_cast<record_type>(header.get_u8());
+    src.size = header.get_u64();
+    src.mtime = header.get_i64();
+
+    uint32_t n = header.get_count(3 * sizeof(uint32_t));
+    table.reserve(n);
+
+    for (uint32_t i = 0; i < n; i++) {
+        entry e;
+        e.tag = header.get_u32();
+        e.offset = header.get_u32();
+        e.length = header.get_u32();
+
+        if (e.offset > len || len - e.offset < e.length) {
+            throw wire_error("truncated record");
+        }
+
+        table.push_back(e);
+    }
+}
+
+bool record_reader::has(uint32_t tag) const {
+    return std::any_of(table.cbegin(), table.cend(), [tag](const entry &e) {
+        return e.tag == tag;
+    });
+}
+
+wire_message record_reader::section(uint32_t tag) const {
+    auto it = std::find_if(table.cbegin(), table.cend(), [tag](const entry &e) {
+        return e.tag == tag;
+    });
+
+    if (it == table.cend()) {
+        throw wire_error("record section missing: " + std::to_string(tag));
+    }
+
+    return wire_message(ptr + it->offset, it->length);
+}
+
+// record_writer
+
+std::string record_writer::finish(record_type type, const fs::file::status &source) const {
+    wire_message header;
+
+    header.put_bytes(record_magic, sizeof(record_magic));
+    header.put_u8(IRIS_RECORD_VERSION);
+    header.put_u8(static_cast<uint8_t>(type));
+    header.put_u64(source.size);
+    header.put_i64(source.mtime);
+    header.put_u32(static_cast<uint32_t>(sections.size()));
+
+    // the data follows the section table (3 x u32 per entry)
+    size_t offset = header.data().size() + sections.size() * 3 * sizeof(uint32_t);
+    for (const auto &s : sections) {
+        header.put_u32(s.first);
+        header.put_u32(static_cast<uint32_t>(offset));
+        header.put_u32(static_cast<uint32_t>(s.second.size()));
+        offset += s.second.size();
+    }
+
+    std::string out = header.data();
+    for (const auto &s : sections) {
+        out += s.second;
+    }
+
+    return out;
+}
+
+static void check_type(const record_reader &record, record_type type) {
+    if (record.type() != type) {
+        throw wire_error("unexpected record type");
+    }
+}
+
+// monitor, rgb2lms, subject
+
+std::string encode_record(const monitor &monitor, const fs::file::status &source) {
+    wire_message msg;
+    msg.put_monitor(monitor);
+
+    record_writer w;
+    w.add(record_section::meta, msg);
+    return w.finish(record_type::monitor, source);
+}
+
+void decode_record(const record_reader &record, monitor &monitor) {
+    check_type(record, record_type::monitor);
+    monitor = record.section(record_section::meta).get_monitor();
+}
+
+std::string encode_record(const rgb2lms &rgb2lms, const fs::file::status &source) {
+    wire_message msg;
+    msg.put_rgb2lms(rgb2lms);
+
+    record_writer w;
+    w.add(record_section::meta, msg);
+    return w.finish(record_type::rgb2lms, source);
+}
+
+void decode_record(const record_reader &record, rgb2lms &rgb2lms) {
+    check_type(record, record_type::rgb2lms);
+    rgb2lms = record.section(record_section::meta).get_rgb2lms();
+}
+
+std::string encode_record(const subject &subject, const fs::file::status &source) {
+    wire_message msg;
+    msg.put_subject(subject);
+
+    record_writer w;
+    w.add(record_section::meta, msg);
+    return w.finish(record_type::subject, source);
+}
+
+void decode_record(const record_reader &record, subject &subject) {
+    check_type(record, record_type::subject);
+    subject = record.section(record_section::meta).get_subject();
+}
+
+// isoslant
+
+std::string encode_record(const isoslant &iso, const fs::file::status &source) {
+    wire_message msg;
+    msg.put_str(iso.identifier());
+    msg.put_str(iso.subject);
+    msg.put_f64(iso.dl);
+    msg.put_f64(iso.phi);
+    msg.put_display(iso.display);
+    msg.put_str(iso.rgb2lms);
+
+    record_writer w;
+    w.add(record_section::meta, msg);
+    return w.finish(record_type::isoslant, source);
+}
+
+void decode_record(const record_reader &record, isoslant &iso) {
+    check_type(record, record_type::isoslant);
+    wire_message msg = record.section(record_section::meta);
+
+    iso = isoslant(msg.get_str());
+    iso.subject = msg.get_str();
+    iso.dl = msg.get_f64();
+    iso.phi = msg.get_f64();
+    iso.display = msg.get_display();
+    iso.rgb2lms = msg.get_str();
+}
+
+// isodata
+
+static_assert(sizeof(isodata::sample) == 2 * sizeof(float), "isodata::sample must be packed");
+
+std::string encode_record(const isodata &data, const fs::file::status &source) {
+    record_writer w;
+
+    wire_message meta;
+    meta.put_str(data.identifier());
+    meta.put_str(data.subject);
+    meta.put_display(data.display);
+    meta.put_str(data.rgb2lms);
+    w.add(record_section::meta, meta);
+
+    wire_message samples;
+    samples.put_u32(static_cast<uint32_t>(data.samples.size()));
+    samples.put_bytes(data.samples.data(), data.samples.size() * sizeof(isodata::sample));
+    w.add(record_section::samples, samples);
+
+    if (!data.trace.empty()) {
+        wire_message trace;
+        trace.put_u32(static_cast<uint32_t>(data.trace.size()));
+        for (const isodata::estimate &e : data.trace) {
+            trace.put_u64(e.trial);
+            trace.put_f64(e.dl);
+            trace.put_f64(e.phi);
+            trace.put_f64(e.dl_ci);
+            trace.put_f64(e.phi_ci);
+        }
+        w.add(record_section::trace, trace);
+    }
+
+    return w.finish(record_type::isodata, source);
+}
+
+void decode_record(const record_reader &record, isodata &data, bool with_data) {
+    check_type(record, record_type::isodata);
+    wire_message meta = record.section(record_section::meta);
+
+    data = isodata(meta.get_str());
+    data.subject = meta.get_str();
+    data.display = meta.get_display();
+    data.rgb2lms = meta.get_str();
+
+    if (!with_data) {
+        return;
+    }
+
+    wire_message samples = record.section(record_section::samples);
+    const size_t ns = samples.get_u32();
+    if (samples.remaining() != ns * sizeof(isodata::sample)) {
+        throw wire_error("malformed isodata samples");
+    }
+
+    data.samples.resize(ns);
+    samples.get_bytes(data.samples.data(), ns * sizeof(isodata::sample));
+
+    if (!record.has(record_section::trace)) {
+        return;
+    }
+
+    wire_message trace = record.section(record_section::trace);
+    const size_t nt = trace.get_u32();
+    if (trace.remaining() != nt * (sizeof(uint64_t) + 4 * sizeof(double))) {
+        throw wire_error("malformed isodata trace");
+    }
+
+    data.trace.resize(nt);
+    for (isodata::estimate &e : data.trace) {
+        e.trial = static_cast<size_t>(trace.get_u64());
+        e.dl = trace.get_f64();
+        e.phi = trace.get_f64();
+        e.dl_ci = trace.get_f64();
+        e.phi_ci = trace.get_f64();
+    }
+}
+
+} //iris::data::
+} //iris::
@@ -0,0 +1,119 @@
+#ifndef IRIS_RECORD_H
+#define IRIS_RECORD_H
+
+#include <data.h>
+#include <wire.h>
+
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace data {
+
+/* binary records
+ *
+ *  Versioned binary encoding of the store records. The YAML files
+ *  stay the (human editable) source of truth, records are a parse
+ *  cache kept in cache/records/ (see store) or written explicitly
+ *  with 'iris-store record'. Layout:
+ *
+ *    magic "IRISREC" + u8 format version
+ *    u8  record type
+ *    u64 size, i64 mtime [ns] of the YAML source (0, -1 if none)
+ *    u32 number of sections
+ *    u32 tag, u32 offset, u32 length for each section
+ *    section data
+ *
+ *  Opening a record reads the header and the section table only,
+ *  sections are decoded on demand. That way e.g. the metadata of an
+ *  isodata record can be had without touching its samples, which
+ *  are stored as a plain array.
+ */
+
+#define IRIS_RECORD_VERSION 1
+
+enum class record_type : uint8_t {
+    monitor  = 1,
+    rgb2lms  = 2,
+    subject  = 3,
+    isoslant = 4,
+    isodata  = 5
+};
+
+enum record_section : uint32_t {
+    meta    = 1,
+    samples = 2, // isodata
+    trace   = 3  // isodata
+};
+
+class record_reader {
+public:
+    explicit record_reader(std::string data);
+
+    // reads the n bytes at data in place, which have to outlive
+    // the reader (e.g. a mapped store pack)
+    record_reader(const char *data, size_t n);
+
+    record_reader(const record_reader &) = delete;
+    record_reader &operator=(const record_reader &) = delete;
+
+    static bool is_record(const std::string &data);
+    static bool is_record(const char *data, size_t n);
+
+    record_type type() const { return rtype; }
+    const fs::file::status &source() const { return src; }
+
+    bool has(uint32_t tag) const;
+
+    // a view into the record, valid as long as the reader is
+    wire_message section(uint32_t tag) const;
+
+private:
+    struct entry {
+        uint32_t tag;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    void parse_header();
+
+    std::string buf;
+    const char *ptr; // buf.data() or the caller's data
+    size_t len;
+    record_type rtype;
+    fs::file::status src;
+    std::vector<entry> table;
+};
+
+class record_writer {
+public:
+    void add(uint32_t tag, const wire_message &msg) {
+        sections.emplace_back(tag, msg.data());
+    }
+
+    std::string finish(record_type type, const fs::file::status &source) const;
+
+private:
+    std::vector<std::pair<uint32_t, std::string>> sections;
+};
+
+const fs::file::status no_source = {0, -1};
+
+std::string encode_record(const monitor &monitor, const fs::file::status &source = no_source);
+std::string encode_record(const rgb2lms &rgb2lms, const fs::file::status &source = no_source);
+std::string encode_record(const subject &subject, const fs::file::status &source = no_source);
+std::string encode_record(const isoslant &iso, const fs::file::status &source = no_source);
+std::string encode_record(const isodata &data, const fs::file::status &source = no_source);
+
+void decode_record(const record_reader &record, monitor &monitor);
+void decode_record(const record_reader &record, rgb2lms &rgb2lms);
+void decode_record(const record_reader &record, subject &subject);
+void decode_record(const record_reader &record, isoslant &iso);
+
+// with_data = false skips the samples and the trace
+void decode_record(const record_reader &record, isodata &data, bool with_data = true);
+
+} //iris::data::
+} //iris::
+
+#endif //IRIS_RECORD_H
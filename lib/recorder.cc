@@ -0,0 +1,150 @@
+#include <recorder.h>
+
+#include <iostream>
+#include <stdexcept>
+
+namespace iris {
+
+recorder::recorder(const std::string &path, mode m, std::chrono::seconds flush_interval)
+        : loc(path),
+          writer(path, m == mode::live ? "as" : "a", 256,
+                 m == mode::live ? std::chrono::milliseconds(0) : flush_interval),
+          n(0), live(m == mode::live), started(false), spectra(0), samples(0) {
+
+    size_t complete = 0;
+
+    writer.post([&complete](h5x::File &fd) {
+        boost::optional<h5x::DataSet> ts = fd.tryOpenData("timestamps");
+        if (!ts) {
+            return;
+        }
+
+        complete = ts->size()[0];
+
+        // drop rows a crash left half-written
+        for (h5x::ndsize_t i = 0; i < fd.objectCount(); i++) {
+            boost::optional<h5x::DataSet> ds = fd.tryOpenData(fd.objectName(i));
+            if (!ds) {
+                continue;
+            }
+
+            h5x::NDSize dims = ds->size();
+            if (dims[0] > complete) {
+                dims[0] = complete;
+                ds->setExtent(dims);
+            }
+        }
+    });
+
+    writer.flush();
+    n = complete;
+
+    if (n > 0) {
+        std::cerr << "[I] continuing " << path << " after row " << n << std::endl;
+    }
+
+    timestamps = writer.column("timestamps", h5x::TypeId::Double);
+}
+
+recorder::~recorder() {
+    try {
+        close();
+    } catch (const std::exception &e) {
+        std::cerr << "[W] could not close " << loc << ": " << e.what() << std::endl;
+    }
+}
+
+void recorder::record(const spectral_data &spec, const columns &extra) {
+    if (spec.data.empty()) {
+        throw std::invalid_argument("recorder: empty spectrum");
+    }
+
+    if (!started) {
+        spectra = writer.column("spectra", h5x::TypeId::Float, spec.data.size(),
+                                h5x::DataSetOptions::compressed());
+        samples = spec.data.size();
+
+        const uint16_t start = spec.wl_start;
+        const uint16_t step = spec.wl_step;
+
+        writer.post([start, step](h5x::File &fd) {
+            h5x::DataSet ds = fd.openData("spectra");
+
+            if (!ds.hasAttr("wl_start")) {
+                ds.setAttr("wl_start", start);
+                ds.setAttr("wl_step", step);
+                return;
+            }
+
+            uint16_t rs = 0, rt = 0;
+            ds.getAttr("wl_start", rs);
+            ds.getAttr("wl_step", rt);
+
+            if (rs != start || rt != step) {
+                throw std::runtime_error("recorder: wavelength range differs from recorded spectra");
+            }
+        });
+
+        for (const auto &kv : extra) {
+            if (kv.second.empty()) {
+                throw std::invalid_argument("recorder: empty column " + kv.first);
+            }
+
+            size_t idx = writer.column(kv.first, h5x::TypeId::Float, kv.second.size());
+            extras[kv.first] = std::make_pair(idx, kv.second.size());
+        }
+
+        // all datasets and attributes exist now
+        if (live) {
+            const std::string path = loc;
+            writer.post([path](h5x::File &fd) {
+                if (fd.swmrCapable()) {
+                    fd.startSwmr();
+                } else {
+                    std::cerr << "[W] " << path << " is in an older format, cannot be followed live" << std::endl;
+                }
+            });
+        }
+
+        started = true;
+    }
+
+    // rows of all columns must line up
+    if (extra.size() != extras.size()) {
+        throw std::invalid_argument("recorder: columns differ from the first record");
+    }
+
+    if (spec.data.size() != samples) {
+        throw std::invalid_argument("recorder: number of samples differs from the first record");
+    }
+
+    cells.clear();
+    cells.push_back({spectra, spec.data.data()});
+
+    for (const auto &kv : extra) {
+        auto it = extras.find(kv.first);
+        if (it == extras.end() || it->second.second != kv.second.size()) {
+            throw std::invalid_argument("recorder: column " + kv.first + " differs from the first record");
+        }
+
+        cells.push_back({it->second.first, kv.second.data()});
+    }
+
+    std::chrono::duration<double> now = std::chrono::system_clock::now().time_since_epoch();
+    const double ts = now.count();
+
+    cells.push_back({timestamps, &ts});
+
+    writer.append(cells.data(), cells.size());
+    n++;
+}
+
+void recorder::flush() {
+    writer.flush();
+}
+
+void recorder::close() {
+    writer.close();
+}
+
+} //iris::
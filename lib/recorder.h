@@ -0,0 +1,104 @@
+#ifndef IRIS_RECORDER_H
+#define IRIS_RECORDER_H
+
+#include <h5x/AsyncWriter.hpp>
+
+#include <pr655.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace iris {
+
+/* recorder
+ *
+ *  Writes the measurements of an acquisition session (iris-measure,
+ *  the LED tools) to an HDF5 file as they arrive, instead of keeping
+ *  them in memory until the end. Every record() appends one row to
+ *
+ *    spectra     [rows x samples] float, attrs wl_start, wl_step,
+ *                shuffled and deflated
+ *    <column>    [rows] or [rows x n] float, for every extra column
+ *    timestamps  [rows] double, seconds since the epoch
+ *
+ *  All datasets are chunked and have an unlimited first dimension.
+ *  The writing happens on a background thread (h5x::AsyncWriter),
+ *  record() only copies the row into a queue and blocks only if the
+ *  queue is full; errors of the writer surface in the next call. The
+ *  file is flushed every flush_interval, so a crash loses at most the
+ *  rows since then. timestamps is written last: a row is complete
+ *  iff it has a timestamp. Re-opening an existing file continues
+ *  after its last complete row.
+ *
+ *  In live mode other processes can follow the file while it is being
+ *  written (HDF5 SWMR, open it with h5x::File::open(path, "rs") and
+ *  refresh() the datasets): the file is flushed whenever the writer
+ *  caught up instead of every flush_interval. Session metadata must
+ *  be set before the first record(), the file is in SWMR mode after.
+ *  If the process dies while in SWMR mode, the file stays marked as
+ *  open for writing: it can still be read ("r" falls back to an SWMR
+ *  reader), but it cannot be continued or written (e.g. by
+ *  iris-calibrate) until the mark is cleared with h5clear -s <file>.
+ */
+class recorder {
+public:
+    typedef std::map<std::string, std::vector<float>> columns;
+
+    enum class mode {
+        batched,
+        live
+    };
+
+    explicit recorder(const std::string &path,
+                      mode m = mode::batched,
+                      std::chrono::seconds flush_interval = std::chrono::seconds(10));
+    ~recorder();
+
+    recorder(const recorder &) = delete;
+    recorder &operator=(const recorder &) = delete;
+
+    // session metadata, stored as attributes of the root group
+    template<typename T>
+    void attr(const std::string &name, const T &value) {
+        writer.post([name, value](h5x::File &fd) {
+            fd.setAttr(name, value);
+        });
+    }
+
+    // several at once, see h5x::LocID::setAttrs()
+    void attrs(const h5x::AttrMap &values) {
+        writer.post([values](h5x::File &fd) {
+            fd.setAttrs(values);
+        });
+    }
+
+    // every call must pass the same extra columns, each with the
+    // same number of values
+    void record(const spectral_data &spec, const columns &extra = columns());
+
+    size_t rows() const { return n; }
+    const std::string &location() const { return loc; }
+
+    void flush();
+    void close();
+
+private:
+    std::string loc;
+    h5x::AsyncWriter writer;
+    size_t n;
+
+    bool live;
+    bool started;
+    size_t spectra;
+    size_t samples;
+    size_t timestamps;
+    std::map<std::string, std::pair<size_t, size_t>> extras; // column, width
+    std::vector<h5x::AsyncWriter::Cell> cells;
+};
+
+} //iris::
+
+#endif //IRIS_RECORDER_H
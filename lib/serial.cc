@@ -1,6 +1,10 @@
 
 #include <serial.h>
 #include <stddef.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <iterator>
 
 namespace device {
 
@@ -54,38 +58,59 @@ serial serial::open(const std::string &str) {
 }
 
 
-void serial::send_data(const std::string &str) {
-    const char *data = str.c_str();
-    const size_t size = str.size();
-    size_t pos = 0;
-
-    //lets say we sleep 10ms per char
-    sleeper timeout(static_cast<sleeper::rep>(size) * 10, 1);
+// wait until fd is ready for events or deadline passed
+static bool poll_until(int fd, short events, serial::clock::time_point deadline) {
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - serial::clock::now());
+        // round up, so we do not spin on the last millisecond
+        int tout = left.count() < 0 ? 0 : static_cast<int>(left.count()) + 1;
 
-    while (pos < size) {
+        struct pollfd pfd = {fd, events, 0};
+        int res = poll(&pfd, 1, tout);
 
-        ssize_t n = write(fd, data + pos, 1);
-        if (n < 0) {
-            throw std::runtime_error("w failed: io error");
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("poll failed: io error");
+        } else if (res == 0) {
+            if (serial::clock::now() < deadline) {
+                continue;
+            }
+            return false;
         }
 
-        pos += static_cast<size_t>(n);
-        if (!timeout.sleep(n == 0)) {
-            throw std::runtime_error("w failed: timeout");
+        if (pfd.revents & (POLLERR | POLLNVAL)) {
+            throw std::runtime_error("poll failed: device error");
+        } else if ((pfd.revents & POLLHUP) && !(pfd.revents & events)) {
+            throw std::runtime_error("poll failed: device hung up");
         }
+
+        return true;
     }
+}
 
-    char cr[1] = {'\r'};
 
-    for (; ;) {
-        ssize_t n = write(fd, cr, 1);
-        if (n == 1) {
-            break;
+void serial::send_data(const std::string &str) {
+    std::string data = str + '\r';
+    size_t pos = 0;
+
+    //lets say we wait 10ms per char
+    auto deadline = clock::now() + std::chrono::milliseconds(data.size() * 10);
+
+    while (pos < data.size()) {
+        ssize_t n = write(fd, data.data() + pos, data.size() - pos);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                throw std::runtime_error("w failed: io error");
+            }
+            n = 0;
         }
 
-        if (!timeout.sleep(n == 0)) {
-            throw std::runtime_error("w failed: timeout");
+        pos += static_cast<size_t>(n);
 
+        if (pos < data.size() && !poll_until(fd, POLLOUT, deadline)) {
+            throw std::runtime_error("w failed: timeout");
         }
     }
 
@@ -99,70 +124,74 @@ void serial::send_data(const std::string &str) {
 }
 
 
-std::vector<char> serial::recv_data(size_t to_read, sleeper::rep read_timeout) {
-    std::vector<char> buf(to_read + 1, 0);
+bool serial::fill(clock::time_point deadline) {
+    char buf[256];
 
-    size_t pos = 0;
-
-    sleeper timeout(read_timeout, 10);
+    for (;;) {
+        ssize_t nread = read(fd, buf, sizeof(buf));
+        if (nread > 0) {
+            rbuf.insert(rbuf.end(), buf, buf + nread);
+            return true;
+        } else if (nread < 0 && errno != EAGAIN && errno != EINTR) {
+            throw std::runtime_error("r failed: io error");
+        }
 
-    while (pos < to_read) {
-        ssize_t nread = read(fd, buf.data() + pos, to_read - pos);
-        if (nread < 0) {
-            if (errno == EAGAIN || errno == EINTR) {
-                nread = 0;
-            } else {
-                throw std::runtime_error("r failed [recv_data]");
-            }
+        if (!poll_until(fd, POLLIN, deadline)) {
+            return false;
         }
+    }
+}
 
-        pos += static_cast<size_t>(nread);
 
-        if (!timeout.sleep(nread == 0)) {
-            throw std::runtime_error("w failed: timeout");
+std::vector<char> serial::recv_data(size_t to_read, sleeper::rep read_timeout) {
+    auto deadline = clock::now() + std::chrono::milliseconds(read_timeout);
+
+    while (rbuf.size() < to_read) {
+        if (!fill(deadline)) {
+            throw std::runtime_error("r failed: timeout");
         }
     }
 
+    std::vector<char> buf(rbuf.begin(), rbuf.begin() + to_read);
+    buf.push_back('\0');
+    rbuf.erase(rbuf.begin(), rbuf.begin() + to_read);
+
     return buf;
 }
 
 
 std::string serial::recv_line(sleeper::rep read_timeout) {
-    sleeper timeout(read_timeout, 1);
+    auto deadline = clock::now() + std::chrono::milliseconds(read_timeout);
 
-    std::vector<char> buf;
+    size_t searched = 0;
+    std::vector<char>::iterator lf;
 
-    char ch = '\0';
-
-    do {
-        ssize_t nread = read(fd, &ch, 1);
-        if (nread < 0) {
-            if (errno == EAGAIN || errno == EINTR) {
-                nread = 0;
-            } else {
-                throw std::runtime_error("r failed [recv_line]");
-            }
-        }
-
-        if (nread > 0 && ch != '\r' && ch != '\n') {
-            buf.push_back(ch);
-        }
-
-        if (!timeout.maybe_sleep(nread == 0)) {
+    while ((lf = std::find(rbuf.begin() + searched, rbuf.end(), '\n')) == rbuf.end()) {
+        searched = rbuf.size();
+        if (!fill(deadline)) {
             throw std::runtime_error("r failed: timeout");
         }
+    }
 
-    } while (ch != '\n');
+    std::string line;
+    std::copy_if(rbuf.begin(), lf, std::back_inserter(line), [](char ch) {
+        return ch != '\r';
+    });
 
-    return std::string(buf.data(), buf.size());
+    rbuf.erase(rbuf.begin(), lf + 1);
+    return line;
 }
 
 
 void serial::eatup() {
+    rbuf.clear();
+
     char buff[255];
-    while ((read(fd, buff, sizeof(buff))) > 0) {
-        wait(10);
+    while (poll_until(fd, POLLIN, clock::now() + std::chrono::milliseconds(10))) {
+        if (read(fd, buff, sizeof(buff)) <= 0) {
+            break;
+        }
     }
 }
 
-} //namespace device
\ No newline at end of file
+} //namespace device
@@ -81,17 +81,13 @@ class serial {
     serial(int fd) : fd(fd) { }
 
 public:
+    typedef std::chrono::steady_clock clock;
+
     serial() : fd(-1) { }
 
-    serial(const serial &other) {
-        fd = dup(other.fd);
-    }
+    serial(const serial &other) : fd(dup(other.fd)), rbuf(other.rbuf) { }
 
-    serial(serial &&other) {
-        if (fd > -1) {
-            close(fd);
-        }
-        fd = other.fd;
+    serial(serial &&other) : fd(other.fd), rbuf(std::move(other.rbuf)) {
         other.fd = -1;
     }
 
@@ -102,6 +98,7 @@ public:
 
         close(fd);
         fd = dup(other.fd);
+        rbuf = other.rbuf;
         return *this;
     }
 
@@ -115,18 +112,23 @@ public:
         }
 
         fd = other.fd;
+        rbuf = std::move(other.rbuf);
         other.fd = -1;
         return *this;
     }
 
     static serial open(const std::string &str);
 
+    // str followed by a CR, written in blocks as the device takes them
     void send_data(const std::string &str);
 
+    // exactly to_read bytes (plus a trailing 0), waits at most read_timeout ms
     std::vector<char> recv_data(size_t to_read, sleeper::rep read_timeout = 5000);
 
+    // up to the next LF, without CR and LF
     std::string recv_line(sleeper::rep read_timeout = 5000);
 
+    // drop everything until the device is quiet for 10 ms
     void eatup();
 
     ~serial() {
@@ -147,7 +149,12 @@ public:
     }
 
 private:
+    // read what is available into rbuf, waiting until deadline for the
+    // first byte; false on timeout
+    bool fill(clock::time_point deadline);
+
     int fd;
+    std::vector<char> rbuf; // received but not yet consumed
 };
 
 } //namespace device
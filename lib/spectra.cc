@@ -231,6 +231,26 @@ spectrum spectra::operator[](const std::string &name) const {
     return this->operator[](static_cast<size_t>(pos));
 }
 
+void spectra::resize(size_t spectra, size_t samples) {
+    if (spectra == n_spectra && samples == n_samples) {
+        return;
+    }
+
+    if (storage != nullptr) {
+        std::allocator<float> al;
+        al.deallocate(storage, n_spectra * n_samples);
+        storage = nullptr;
+    }
+
+    if (spectra != n_spectra) {
+        ids.clear();
+    }
+
+    n_spectra = spectra;
+    n_samples = samples;
+    allocate();
+}
+
 void spectra::allocate() {
     size_t n = n_spectra * n_samples;
     if (n < 1) {
@@ -88,7 +88,7 @@ public:
 
 public:
 
-    spectra() : storage(nullptr), n_spectra(0), n_samples(0) {}
+    spectra() : storage(nullptr), n_spectra(0), n_samples(0), wl_start(0), wl_step(0) {}
     spectra(size_t spectra, size_t samples, uint16_t start, uint16_t step)
             : storage(nullptr), n_spectra(spectra), n_samples(samples),
               wl_start(start), wl_step(step), ids() {
@@ -133,6 +133,14 @@ public:
         return wl_step;
     }
 
+    void lambda(uint16_t start, uint16_t step) {
+        wl_start = start;
+        wl_step = step;
+    }
+
+    // discards the values (and the names if the number of spectra changes)
+    void resize(size_t spectra, size_t samples);
+
     ssize_t find_spectrum(const std::string &id) const;
 
     spectrum operator[](size_t n) const;
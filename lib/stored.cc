@@ -0,0 +1,646 @@
+#include <stored.h>
+#include <watch.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace iris {
+namespace data {
+
+enum class op : uint8_t {
+    hello           = 1,
+    default_monitor = 2,
+    load_monitor    = 3,
+    make_display    = 4,
+    load_rgb2lms    = 5,
+    find_subjects   = 6
+};
+
+static const uint8_t status_ok = 0;
+static const uint8_t status_error = 1;
+
+// nothing we send comes close, but a garbled length must not
+// make us allocate the world
+static const uint32_t max_message_size = 16 * 1024 * 1024;
+
+std::string store_service_path() {
+    const char *env = getenv("IRIS_STORED_SOCKET");
+    if (env != nullptr && env[0] != '\0') {
+        return env;
+    }
+
+    env = getenv("XDG_RUNTIME_DIR");
+    if (env != nullptr && env[0] != '\0') {
+        return std::string(env) + "/iris-stored.sock";
+    }
+
+    return "/tmp/iris-stored-" + std::to_string(getuid()) + ".sock";
+}
+
+// socket IO
+
+static bool send_all(int fd, const char *data, size_t n) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+
+    while (n > 0) {
+        ssize_t k = ::send(fd, data, n, flags);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        } else if (k <= 0) {
+            return false;
+        }
+
+        data += k;
+        n -= static_cast<size_t>(k);
+    }
+
+    return true;
+}
+
+static bool recv_all(int fd, char *data, size_t n) {
+    while (n > 0) {
+        ssize_t k = ::recv(fd, data, n, 0);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        } else if (k <= 0) {
+            return false;
+        }
+
+        data += k;
+        n -= static_cast<size_t>(k);
+    }
+
+    return true;
+}
+
+static bool send_message(int fd, const wire_message &msg) {
+    const std::string &data = msg.data();
+    uint32_t len = static_cast<uint32_t>(data.size());
+
+    return send_all(fd, reinterpret_cast<const char *>(&len), sizeof(len)) &&
+           send_all(fd, data.data(), data.size());
+}
+
+static bool recv_message(int fd, wire_message &msg) {
+    uint32_t len;
+    if (!recv_all(fd, reinterpret_cast<char *>(&len), sizeof(len)) || len > max_message_size) {
+        return false;
+    }
+
+    std::string data(len, '\0');
+    if (len > 0 && !recv_all(fd, &data[0], len)) {
+        return false;
+    }
+
+    msg = wire_message(std::move(data));
+    return true;
+}
+
+static sockaddr_un make_address(const std::string &path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("socket path too long: " + path);
+    }
+
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+static int connect_socket(const std::string &path) {
+    sockaddr_un addr = make_address(path);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// whoever answers sets the store location of every tool, so it
+// has to be us and not some other user who got to the path first
+static bool peer_is_user(int fd) {
+#if defined(SO_PEERCRED)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        return false;
+    }
+    return cred.uid == getuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) < 0) {
+        return false;
+    }
+    return uid == getuid();
+#else
+    (void) fd;
+    return false; // cannot tell, so do not trust it
+#endif
+}
+
+// store_client
+
+std::shared_ptr<store_client> store_client::connect(const std::string &path) {
+    struct stat st;
+    if (::lstat(path.c_str(), &st) < 0) {
+        return nullptr;
+    }
+
+    if (!S_ISSOCK(st.st_mode) || st.st_uid != getuid()) {
+        std::cerr << "[W] ignoring store service @ " << path << ": not a socket of ours" << std::endl;
+        return nullptr;
+    }
+
+    int fd = connect_socket(path);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    if (!peer_is_user(fd)) {
+        std::cerr << "[W] ignoring store service @ " << path << ": runs as another user" << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+
+    // a hanging service should not hang the tools
+    struct timeval tv = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    std::shared_ptr<store_client> client(new store_client(fd));
+
+    try {
+        wire_message req;
+        req.put_u8(static_cast<uint8_t>(op::hello));
+        req.put_u32(IRIS_STORED_PROTOCOL);
+
+        wire_message res = client->call(req);
+        client->loc = res.get_str();
+        client->ver = res.get_str();
+
+    } catch (const std::exception &e) {
+        std::cerr << "[W] ignoring store service @ " << path << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+
+    return client;
+}
+
+store_client::~store_client() {
+    ::close(fd);
+}
+
+wire_message store_client::call(const wire_message &req) {
+    wire_message res;
+
+    if (!send_message(fd, req) || !recv_message(fd, res)) {
+        throw wire_error("connection to store service lost");
+    }
+
+    if (res.get_u8() != status_ok) {
+        throw std::runtime_error(res.get_str());
+    }
+
+    return res;
+}
+
+std::string store_client::default_monitor() {
+    wire_message req;
+    req.put_u8(static_cast<uint8_t>(op::default_monitor));
+    return call(req).get_str();
+}
+
+monitor store_client::load_monitor(const std::string &uid) {
+    wire_message req;
+    req.put_u8(static_cast<uint8_t>(op::load_monitor));
+    req.put_str(uid);
+    return call(req).get_monitor();
+}
+
+display store_client::make_display(const monitor &monitor, const monitor::mode &mode, const std::string &gfx) {
+    wire_message req;
+    req.put_u8(static_cast<uint8_t>(op::make_display));
+    req.put_monitor(monitor);
+    req.put_mode(mode);
+    req.put_str(gfx);
+    return call(req).get_display();
+}
+
+rgb2lms store_client::load_rgb2lms(const display &display) {
+    wire_message req;
+    req.put_u8(static_cast<uint8_t>(op::load_rgb2lms));
+    req.put_display(display);
+    return call(req).get_rgb2lms();
+}
+
+std::vector<subject> store_client::find_subjects(const std::string &phrase, int how) {
+    wire_message req;
+    req.put_u8(static_cast<uint8_t>(op::find_subjects));
+    req.put_str(phrase);
+    req.put_i32(how);
+
+    wire_message res = call(req);
+    std::vector<subject> hits(res.get_count(3 * sizeof(uint32_t)));
+    std::generate(hits.begin(), hits.end(), [&res]() {
+        return res.get_subject();
+    });
+
+    return hits;
+}
+
+// store_server
+
+store_server::store_server(const store &store, const std::string &path)
+        : st(store), path(path), lfd(-1), running(0) {
+
+    sockaddr_un addr = make_address(path);
+
+    // a socket file is left behind if a previous server died
+    int probe = connect_socket(path);
+    if (probe >= 0) {
+        ::close(probe);
+        throw std::runtime_error("store service already running @ " + path);
+    }
+    ::unlink(path.c_str());
+
+    lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        throw std::runtime_error("Could not create socket");
+    }
+
+    // only the owner gets to talk to us
+    mode_t old_mask = ::umask(0077);
+    int res = ::bind(lfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    ::umask(old_mask);
+
+    if (res < 0 || ::listen(lfd, 16) < 0) {
+        ::close(lfd);
+        throw std::runtime_error("Could not listen on " + path + ": " + strerror(errno));
+    }
+
+    try {
+        watcher = st.watch();
+        watcher->subscribe([this](const store_event &ev) {
+            invalidate(ev);
+        });
+    } catch (const std::exception &e) {
+        std::cerr << "[W] not caching store data: " << e.what() << std::endl;
+    }
+}
+
+store_server::~store_server() {
+    ::close(lfd);
+    ::unlink(path.c_str());
+}
+
+void store_server::run() {
+    std::vector<client> clients;
+    std::vector<pollfd> fds;
+
+    running = 1;
+    while (running) {
+        fds.clear();
+        fds.push_back({lfd, POLLIN, 0});
+        fds.push_back({watcher ? watcher->fd() : -1, POLLIN, 0});
+
+        // a client with responses pending has to read them first
+        for (const client &c : clients) {
+            fds.push_back({c.fd, static_cast<short>(c.out.empty() ? POLLIN : POLLOUT), 0});
+        }
+
+        // the timeout covers a stop() between the check and poll()
+        int n = ::poll(fds.data(), fds.size(), 1000);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+        }
+
+        // changes that happened before a request must be seen by it
+        if (watcher) {
+            watcher->poll();
+        }
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            client &c = clients[i];
+            const short ev = fds[i + 2].revents;
+
+            bool keep = true;
+            if (ev & POLLOUT) {
+                keep = flush(c);
+            } else if (ev != 0) {
+                keep = receive(c) && flush(c);
+            }
+
+            if (!keep) {
+                ::close(c.fd);
+                c.fd = -1;
+            }
+        }
+
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const client &c) {
+            return c.fd < 0;
+        }), clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            int cfd = ::accept(lfd, nullptr, nullptr);
+            if (cfd >= 0) {
+#ifdef SO_NOSIGPIPE
+                int one = 1;
+                setsockopt(cfd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+                int flags = ::fcntl(cfd, F_GETFL);
+                if (flags < 0 || ::fcntl(cfd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                    ::close(cfd);
+                } else {
+                    clients.push_back(client{cfd, std::string(), std::string()});
+                }
+            }
+        }
+    }
+
+    std::for_each(clients.begin(), clients.end(), [](const client &c) {
+        ::close(c.fd);
+    });
+}
+
+// read what is there and answer all complete requests;
+// false if the client is gone or misbehaves
+bool store_server::receive(client &c) {
+    char buf[4096];
+
+    for (;;) {
+        ssize_t k = ::recv(c.fd, buf, sizeof(buf), 0);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (k <= 0) {
+            return false;
+        }
+
+        c.in.append(buf, static_cast<size_t>(k));
+    }
+
+    size_t pos = 0;
+    while (c.in.size() - pos >= sizeof(uint32_t)) {
+        uint32_t len;
+        memcpy(&len, c.in.data() + pos, sizeof(len));
+
+        if (len > max_message_size) {
+            return false;
+        } else if (c.in.size() - pos - sizeof(len) < len) {
+            break;
+        }
+
+        wire_message req(c.in.substr(pos + sizeof(len), len));
+        pos += sizeof(len) + len;
+
+        wire_message res;
+        try {
+            res = serve(req);
+        } catch (const wire_error &e) {
+            std::cerr << "[W] dropping client: " << e.what() << std::endl;
+            return false;
+        }
+
+        const std::string &data = res.data();
+        uint32_t rlen = static_cast<uint32_t>(data.size());
+        c.out.append(reinterpret_cast<const char *>(&rlen), sizeof(rlen));
+        c.out.append(data);
+    }
+
+    c.in.erase(0, pos);
+    return true;
+}
+
+// send as much of the pending responses as the socket takes
+bool store_server::flush(client &c) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+
+    size_t pos = 0;
+    while (pos < c.out.size()) {
+        ssize_t k = ::send(c.fd, c.out.data() + pos, c.out.size() - pos, flags);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (k <= 0) {
+            return false;
+        }
+
+        pos += static_cast<size_t>(k);
+    }
+
+    c.out.erase(0, pos);
+    return true;
+}
+
+wire_message store_server::serve(wire_message &req) {
+    try {
+        return dispatch(req);
+    } catch (const wire_error &) {
+        throw;
+    } catch (const std::exception &e) {
+        wire_message res;
+        res.put_u8(status_error);
+        res.put_str(e.what());
+        return res;
+    }
+}
+
+wire_message store_server::dispatch(wire_message &req) {
+    wire_message res;
+    res.put_u8(status_ok);
+
+    switch (static_cast<op>(req.get_u8())) {
+
+    case op::hello: {
+        uint32_t protocol = req.get_u32();
+        if (protocol != IRIS_STORED_PROTOCOL) {
+            throw std::runtime_error("protocol mismatch: " + std::to_string(protocol) +
+                                     " [" + std::to_string(IRIS_STORED_PROTOCOL) + "]");
+        }
+
+        res.put_str(st.location().path());
+        res.put_str(st.version_string());
+        break;
+    }
+
+    case op::default_monitor:
+        if (default_mon.empty() || !watcher) {
+            default_mon = st.default_monitor();
+        }
+        res.put_str(default_mon);
+        break;
+
+    case op::load_monitor:
+        res.put_monitor(cached_monitor(req.get_str()));
+        break;
+
+    case op::make_display: {
+        monitor moni = req.get_monitor();
+        monitor::mode mode = req.get_mode();
+        std::string gfx = req.get_str();
+        res.put_display(cached_display(moni, mode, gfx));
+        break;
+    }
+
+    case op::load_rgb2lms:
+        res.put_rgb2lms(cached_rgb2lms(req.get_display()));
+        break;
+
+    case op::find_subjects: {
+        std::string phrase = req.get_str();
+        int how = req.get_i32();
+
+        std::vector<subject> hits = st.find_subjects(phrase, how);
+        res.put_u32(static_cast<uint32_t>(hits.size()));
+        std::for_each(hits.cbegin(), hits.cend(), [&res](const subject &s) {
+            res.put_subject(s);
+        });
+        break;
+    }
+
+    default:
+        throw std::runtime_error("unknown request");
+    }
+
+    return res;
+}
+
+// parsed store data; misses (errors) are not cached
+
+static std::string display_key(const display &dsy) {
+    return dsy.monitor_id + '\0' + dsy.settings_id + '\0' + dsy.link_id + '\0' + dsy.gfx;
+}
+
+monitor store_server::cached_monitor(const std::string &uid) {
+    auto it = monitors.find(uid);
+    if (it != monitors.end()) {
+        return it->second;
+    }
+
+    monitor moni = st.load_monitor(uid);
+    if (watcher) {
+        monitors.insert(std::make_pair(uid, moni));
+    }
+    return moni;
+}
+
+display store_server::cached_display(const monitor &monitor, const monitor::mode &mode, const std::string &gfx) {
+    const std::string key = monitor.identifier() + '\0' + gfx;
+
+    auto it = displays.find(key);
+    if (it == displays.end()) {
+        display dsy = st.make_display(monitor, mode, gfx);
+        if (!watcher) {
+            return dsy;
+        }
+        it = displays.insert(std::make_pair(key, dsy)).first;
+    }
+
+    // links.cfg and the settings do not depend on the mode
+    display dsy = it->second;
+    dsy.mode = mode;
+    return dsy;
+}
+
+rgb2lms store_server::cached_rgb2lms(const display &display) {
+    const std::string key = display_key(display);
+
+    auto it = calibrations.find(key);
+    if (it != calibrations.end()) {
+        return it->second;
+    }
+
+    rgb2lms ca = st.load_rgb2lms(display);
+    if (watcher) {
+        calibrations.insert(std::make_pair(key, ca));
+    }
+    return ca;
+}
+
+// entries of a monitor (keys start with its id)
+template<typename T>
+static void erase_monitor(std::map<std::string, T> &cache, const std::string &id) {
+    const std::string prefix = id + '\0';
+    auto it = cache.lower_bound(prefix);
+    while (it != cache.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        it = cache.erase(it);
+    }
+}
+
+void store_server::invalidate(const store_event &ev) {
+    switch (ev.what) {
+
+    case store_event::kind::store:
+        default_mon.clear();
+        monitors.clear();
+        displays.clear();
+        calibrations.clear();
+        break;
+
+    case store_event::kind::default_monitor:
+        default_mon.clear();
+        break;
+
+    case store_event::kind::links:
+        displays.clear();
+        break;
+
+    case store_event::kind::monitor:
+        monitors.erase(ev.id);
+        erase_monitor(displays, ev.id);
+        erase_monitor(calibrations, ev.id);
+        break;
+
+    case store_event::kind::settings:
+        // the latest settings might have changed
+        erase_monitor(displays, ev.id);
+        break;
+
+    case store_event::kind::rgb2lms:
+        erase_monitor(calibrations, ev.id);
+        break;
+
+    case store_event::kind::subject:
+        break; // the store's own subject cache handles these
+    }
+}
+
+} //iris::data::
+} //iris::
\ No newline at end of file
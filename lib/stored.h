@@ -0,0 +1,118 @@
+#ifndef IRIS_STORED_H
+#define IRIS_STORED_H
+
+#include <data.h>
+#include <wire.h>
+
+#include <csignal>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace data {
+
+/* resident store service (iris-stored)
+ *
+ *  Serves queries on a data::store over a local unix socket, so
+ *  that tools do not have to locate, read and parse the store on
+ *  every invocation. store::default_store() uses the service if
+ *  one is listening and falls back to direct access otherwise.
+ *
+ *  Every message is a u32 length followed by the payload (see
+ *  wire.h). Requests start with an op code (u8), responses with a
+ *  status (u8; 0 = ok, 1 = error followed by the message).
+ *
+ *  The service keeps the parsed monitors, displays and the latest
+ *  rgb2lms per display in memory and drops them when the store
+ *  watcher (watch.h) reports a change. Clients only talk to a
+ *  socket owned by, and a service running as, their own user.
+ */
+
+#define IRIS_STORED_PROTOCOL 1
+
+// $IRIS_STORED_SOCKET, or iris-stored.sock in $XDG_RUNTIME_DIR,
+// or /tmp/iris-stored-<uid>.sock (the socket file and the service
+// have to belong to the user, see store_client::connect)
+std::string store_service_path();
+
+class store_client {
+public:
+    // nullptr if no (compatible) service is listening at path
+    static std::shared_ptr<store_client> connect(const std::string &path);
+    ~store_client();
+
+    store_client(const store_client &) = delete;
+    store_client &operator=(const store_client &) = delete;
+
+    const std::string &location() const { return loc; }
+    const std::string &version() const { return ver; }
+
+    std::string default_monitor();
+    monitor load_monitor(const std::string &uid);
+    display make_display(const monitor &monitor, const monitor::mode &mode, const std::string &gfx);
+    rgb2lms load_rgb2lms(const display &display);
+    std::vector<subject> find_subjects(const std::string &phrase, int how);
+
+private:
+    explicit store_client(int fd) : fd(fd) { }
+    wire_message call(const wire_message &req);
+
+private:
+    int fd;
+    std::string loc;
+    std::string ver;
+};
+
+class store_server {
+public:
+    store_server(const store &store, const std::string &path);
+    ~store_server();
+
+    store_server(const store_server &) = delete;
+    store_server &operator=(const store_server &) = delete;
+
+    // serve until stop() is called
+    void run();
+
+    // safe to call from a signal handler
+    void stop() { running = 0; }
+
+private:
+    // clients are non-blocking, a stalled one must not stall the rest
+    struct client {
+        int fd;
+        std::string in;  // received, but not a complete request yet
+        std::string out; // responses not sent yet
+    };
+
+    bool receive(client &c);
+    bool flush(client &c);
+    wire_message serve(wire_message &req);
+    wire_message dispatch(wire_message &req);
+
+    monitor cached_monitor(const std::string &uid);
+    display cached_display(const monitor &monitor, const monitor::mode &mode, const std::string &gfx);
+    rgb2lms cached_rgb2lms(const display &display);
+    void invalidate(const store_event &ev);
+
+private:
+    store st;
+    std::string path;
+    int lfd;
+    volatile std::sig_atomic_t running;
+
+    // nullptr if the store cannot be watched, nothing is cached then
+    std::unique_ptr<store_watcher> watcher;
+    std::string default_mon;
+    std::map<std::string, monitor> monitors;      // by id
+    std::map<std::string, display> displays;      // by monitor id, gfx
+    std::map<std::string, rgb2lms> calibrations;  // by display
+};
+
+} //iris::data::
+} //iris::
+
+#endif //IRIS_STORED_H
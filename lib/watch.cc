@@ -0,0 +1,265 @@
+#include <watch.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace iris {
+namespace data {
+
+#ifdef __linux__
+
+store_watcher::store_watcher(store &st) : st(st), ifd(-1), journal_pos(0) {
+
+    // only what is journaled from now on is of interest
+    std::vector<journal_entry> skipped;
+    st.read_journal(journal_pos, skipped);
+
+    ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ifd < 0) {
+        throw std::runtime_error("Could not initialize inotify");
+    }
+
+    fs::file base = st.location();
+    add(base, scope::base, "");
+
+    fs::file mdir = base.child("monitors");
+    if (mdir.exists()) {
+        add(mdir, scope::monitors, "");
+    }
+
+    fs::file sdir = base.child("subjects");
+    if (sdir.exists()) {
+        add(sdir, scope::subjects, "");
+    }
+}
+
+store_watcher::~store_watcher() {
+    ::close(ifd);
+}
+
+void store_watcher::add(const fs::file &dir, scope where, const std::string &id) {
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_ONLYDIR;
+
+    int wd = inotify_add_watch(ifd, dir.path().c_str(), mask);
+    if (wd < 0) {
+        std::cerr << "[W] cannot watch " << dir.path() << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    targets[wd] = target{where, id, dir};
+
+    // directories of monitors and subjects
+    if (where != scope::monitors && where != scope::subjects) {
+        return;
+    }
+
+    const scope sub = where == scope::monitors ? scope::monitor : scope::subject;
+    for (const fs::dir_entry &e : fs::scan(dir)) {
+        if (e.is_directory(dir)) {
+            add(dir.child(e.name), sub, e.name);
+        }
+    }
+}
+
+static std::string extension(const std::string &name) {
+    size_t pos = name.rfind('.');
+    return pos == std::string::npos ? std::string() : name.substr(pos);
+}
+
+bool store_watcher::classify(const target &t, uint32_t mask, const std::string &name, store_event &ev) {
+    const bool is_dir = (mask & IN_ISDIR) != 0;
+    const bool appeared = (mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+
+    // regular files show up on IN_CREATE while still being written,
+    // only symlinks (default.monitor) are complete at that point
+    const bool incomplete = !is_dir && (mask & IN_CREATE) != 0;
+
+    switch (t.where) {
+
+    case scope::base:
+        if (is_dir && appeared && name == "monitors") {
+            add(t.dir.child(name), scope::monitors, "");
+        } else if (is_dir && appeared && name == "subjects") {
+            add(t.dir.child(name), scope::subjects, "");
+        } else if (name == "default.monitor") {
+            ev = store_event{store_event::kind::default_monitor, "", name};
+            return true;
+        } else if (name == "links.cfg" && !incomplete) {
+            ev = store_event{store_event::kind::links, "", name};
+            return true;
+        }
+        return false;
+
+    case scope::monitors:
+    case scope::subjects:
+        if (!is_dir) {
+            return false;
+        }
+
+        if (appeared) {
+            add(t.dir.child(name), t.where == scope::monitors ? scope::monitor : scope::subject, name);
+        }
+
+        ev.what = t.where == scope::monitors ? store_event::kind::monitor : store_event::kind::subject;
+        ev.id = name;
+        ev.name = "";
+        return true;
+
+    case scope::monitor: {
+        if (is_dir || incomplete) {
+            return false;
+        }
+
+        const std::string ext = extension(name);
+        if (ext == ".rgb2lms") {
+            ev.what = store_event::kind::rgb2lms;
+        } else if (ext == ".settings") {
+            ev.what = store_event::kind::settings;
+        } else if (ext == ".monitor") {
+            ev.what = store_event::kind::monitor;
+        } else {
+            return false;
+        }
+
+        ev.id = t.id;
+        ev.name = name;
+        return true;
+    }
+
+    case scope::subject: {
+        const std::string ext = extension(name);
+        if (is_dir || incomplete || (ext != ".subject" && ext != ".isoslant")) {
+            return false;
+        }
+
+        ev = store_event{store_event::kind::subject, t.id, name};
+        return true;
+    }
+    }
+
+    return false;
+}
+
+// files the store writes atomically via link() only show up as
+// IN_CREATE, which is ignored above, so take them from the journal
+void store_watcher::journal_events(std::vector<store_event> &events) {
+    std::vector<journal_entry> entries;
+    if (!st.read_journal(journal_pos, entries)) {
+        events.push_back(store_event{store_event::kind::store, "", ""});
+        return;
+    }
+
+    for (const journal_entry &j : entries) {
+        size_t a = j.path.find('/');
+        size_t b = a == std::string::npos ? a : j.path.find('/', a + 1);
+        if (b == std::string::npos) {
+            continue;
+        }
+
+        const std::string top = j.path.substr(0, a);
+        if (top != "monitors" && top != "subjects") {
+            continue;
+        }
+
+        const scope where = top == "monitors" ? scope::monitor : scope::subject;
+        target t{where, j.path.substr(a + 1, b - a - 1), st.location().child(j.path.substr(0, b))};
+
+        store_event ev;
+        if (classify(t, IN_MOVED_TO, j.path.substr(b + 1), ev) &&
+            std::find(events.cbegin(), events.cend(), ev) == events.cend()) {
+            events.push_back(ev);
+        }
+    }
+}
+
+size_t store_watcher::poll() {
+    std::vector<store_event> events;
+
+    alignas(struct inotify_event) char buf[4096];
+
+    for (;;) {
+        ssize_t n = ::read(ifd, buf, sizeof(buf));
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            break; // EAGAIN, i.e. nothing (more) pending
+        }
+
+        for (char *p = buf; p < buf + n; ) {
+            const struct inotify_event *ie = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + ie->len;
+
+            store_event ev;
+
+            if (ie->mask & IN_Q_OVERFLOW) {
+                ev = store_event{store_event::kind::store, "", ""};
+            } else {
+                auto it = targets.find(ie->wd);
+                if (it == targets.end()) {
+                    continue;
+                } else if (ie->mask & IN_IGNORED) {
+                    targets.erase(it);
+                    continue;
+                }
+
+                const target t = it->second;
+                const std::string name = ie->len > 0 ? std::string(ie->name) : std::string();
+
+                if (t.where == scope::base && name == "journal" && (ie->mask & IN_CLOSE_WRITE)) {
+                    journal_events(events);
+                    continue;
+                } else if (!classify(t, ie->mask, name, ev)) {
+                    continue;
+                }
+            }
+
+            if (std::find(events.cbegin(), events.cend(), ev) == events.cend()) {
+                events.push_back(ev);
+            }
+        }
+    }
+
+    for (const store_event &ev : events) {
+        st.invalidate(ev);
+
+        for (const callback &cb : subscribers) {
+            cb(ev);
+        }
+    }
+
+    return events.size();
+}
+
+#else
+
+store_watcher::store_watcher(store &st) : st(st), ifd(-1), journal_pos(0) {
+    throw std::runtime_error("watching the store needs inotify (linux)");
+}
+
+store_watcher::~store_watcher() { }
+
+void store_watcher::add(const fs::file &, scope, const std::string &) { }
+
+bool store_watcher::classify(const target &, uint32_t, const std::string &, store_event &) {
+    return false;
+}
+
+void store_watcher::journal_events(std::vector<store_event> &) { }
+
+size_t store_watcher::poll() {
+    return 0;
+}
+
+#endif
+
+} //iris::data::
+} //iris::
@@ -0,0 +1,90 @@
+#ifndef IRIS_WATCH_H
+#define IRIS_WATCH_H
+
+#include <data.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace data {
+
+struct store_event {
+    enum class kind {
+        store,           // events were lost, anything might have changed
+        default_monitor, // default.monitor link
+        links,           // links.cfg
+        monitor,         // monitor added or its .monitor file changed
+        settings,
+        rgb2lms,
+        subject
+    };
+
+    kind what;
+    std::string id;   // monitor or subject, empty for store wide files
+    std::string name; // file name, if any
+
+    bool operator==(const store_event &o) const {
+        return what == o.what && id == o.id && name == o.name;
+    }
+};
+
+/* store_watcher
+ *
+ *  Notices changes to the store (new calibrations, a changed
+ *  default monitor, ...) via inotify. Events are collected by the
+ *  kernel and only delivered when poll() is called, i.e. on the
+ *  caller's thread and at a point of its choosing (between trials,
+ *  once per frame, ...). Cached data of the store is invalidated
+ *  before subscribers are called.
+ *
+ *  The store passed to store::watch() must outlive the watcher.
+ */
+class store_watcher {
+public:
+    typedef std::function<void(const store_event &)> callback;
+
+    ~store_watcher();
+
+    store_watcher(const store_watcher &) = delete;
+    store_watcher &operator=(const store_watcher &) = delete;
+
+    void subscribe(callback cb) { subscribers.push_back(cb); }
+
+    // deliver pending events, never blocks; returns the number of
+    // (de-duplicated) events delivered
+    size_t poll();
+
+    // to integrate with select() & co.
+    int fd() const { return ifd; }
+
+private:
+    friend class store;
+    explicit store_watcher(store &st);
+
+    enum class scope { base, monitors, monitor, subjects, subject };
+
+    struct target {
+        scope where;
+        std::string id;
+        fs::file dir;
+    };
+
+    void add(const fs::file &dir, scope where, const std::string &id);
+    bool classify(const target &t, uint32_t mask, const std::string &name, store_event &ev);
+    void journal_events(std::vector<store_event> &events);
+
+private:
+    store &st;
+    int ifd;
+    uint64_t journal_pos;
+    std::map<int, target> targets;
+    std::vector<callback> subscribers;
+};
+
+} //iris::data::
+} //iris::
+
+#endif //IRIS_WATCH_H
@@ -0,0 +1,165 @@
+#include <wire.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace iris {
+namespace data {
+
+const std::string &wire_message::data() const {
+    if (view != nullptr) {
+        throw std::logic_error("wire_message: no data() for views");
+    }
+
+    return buf;
+}
+
+void wire_message::put(const void *data, size_t n) {
+    if (view != nullptr) {
+        throw std::logic_error("wire_message: views are read-only");
+    }
+
+    buf.append(static_cast<const char *>(data), n);
+}
+
+void wire_message::get(void *data, size_t n) {
+    if (size() - pos < n) {
+        throw wire_error("malformed message");
+    } else if (n == 0) {
+        return;
+    }
+
+    memcpy(data, begin() + pos, n);
+    pos += n;
+}
+
+void wire_message::put_str(const std::string &str) {
+    put_u32(static_cast<uint32_t>(str.size()));
+    put(str.data(), str.size());
+}
+
+std::string wire_message::get_str() {
+    uint32_t n = get_u32();
+    if (size() - pos < n) {
+        throw wire_error("malformed message");
+    }
+
+    std::string str(begin() + pos, n);
+    pos += n;
+    return str;
+}
+
+uint32_t wire_message::get_count(size_t min_size) {
+    uint32_t n = get_u32();
+    if (min_size > 0 && n > remaining() / min_size) {
+        throw wire_error("malformed message");
+    }
+
+    return n;
+}
+
+void wire_message::put_mode(const monitor::mode &mode) {
+    put_f32(mode.width);
+    put_f32(mode.height);
+    put_f32(mode.refresh);
+    put_i32(mode.r);
+    put_i32(mode.g);
+    put_i32(mode.b);
+}
+
+monitor::mode wire_message::get_mode() {
+    monitor::mode mode;
+    mode.width = get_f32();
+    mode.height = get_f32();
+    mode.refresh = get_f32();
+    mode.r = get_i32();
+    mode.g = get_i32();
+    mode.b = get_i32();
+    return mode;
+}
+
+void wire_message::put_display(const display &dsy) {
+    put_str(dsy.monitor_id);
+    put_str(dsy.settings_id);
+    put_str(dsy.link_id);
+    put_str(dsy.gfx);
+    put_mode(dsy.mode);
+}
+
+display wire_message::get_display() {
+    display dsy;
+    dsy.monitor_id = get_str();
+    dsy.settings_id = get_str();
+    dsy.link_id = get_str();
+    dsy.gfx = get_str();
+    dsy.mode = get_mode();
+    return dsy;
+}
+
+void wire_message::put_monitor(const monitor &monitor) {
+    put_str(monitor.identifier());
+    put_str(monitor.vendor);
+    put_str(monitor.name);
+    put_str(monitor.year);
+    put_str(monitor.notes);
+    put_str(monitor.serial);
+    put_mode(monitor.default_mode);
+}
+
+monitor wire_message::get_monitor() {
+    monitor monitor(get_str());
+    monitor.vendor = get_str();
+    monitor.name = get_str();
+    monitor.year = get_str();
+    monitor.notes = get_str();
+    monitor.serial = get_str();
+    monitor.default_mode = get_mode();
+    return monitor;
+}
+
+void wire_message::put_rgb2lms(const rgb2lms &rgb2lms) {
+    put_str(rgb2lms.identifier());
+    put_f32(rgb2lms.width);
+    put_f32(rgb2lms.height);
+    put_f32(rgb2lms.gray_level);
+    put_display(rgb2lms.dsy);
+
+    const dkl::parameter &p = rgb2lms.dkl_params;
+    std::for_each(p.A_zero, p.A_zero + 3, [this](double v) { put_f64(v); });
+    std::for_each(p.A, p.A + 9, [this](double v) { put_f64(v); });
+    std::for_each(p.gamma, p.gamma + 3, [this](double v) { put_f64(v); });
+
+    put_str(rgb2lms.dataset);
+}
+
+rgb2lms wire_message::get_rgb2lms() {
+    rgb2lms rgb2lms(get_str());
+    rgb2lms.width = get_f32();
+    rgb2lms.height = get_f32();
+    rgb2lms.gray_level = get_f32();
+    rgb2lms.dsy = get_display();
+
+    dkl::parameter &p = rgb2lms.dkl_params;
+    std::generate(p.A_zero, p.A_zero + 3, [this]() { return get_f64(); });
+    std::generate(p.A, p.A + 9, [this]() { return get_f64(); });
+    std::generate(p.gamma, p.gamma + 3, [this]() { return get_f64(); });
+
+    rgb2lms.dataset = get_str();
+    return rgb2lms;
+}
+
+void wire_message::put_subject(const subject &subject) {
+    put_str(subject.identifier());
+    put_str(subject.initials);
+    put_str(subject.name);
+}
+
+subject wire_message::get_subject() {
+    subject subject(get_str());
+    subject.initials = get_str();
+    subject.name = get_str();
+    return subject;
+}
+
+} //iris::data::
+} //iris::
@@ -0,0 +1,99 @@
+#ifndef IRIS_WIRE_H
+#define IRIS_WIRE_H
+
+#include <data.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace iris {
+namespace data {
+
+/* wire_message
+ *
+ *  Compact binary encoding of store data, used by the store service
+ *  (stored.h) and the binary records (record.h). Strings are a u32
+ *  length plus the bytes, all numbers are in host byte order: the
+ *  data never leaves the machine it was written on.
+ */
+
+// malformed or truncated binary data (or a failure to talk
+// to the store service)
+class wire_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class wire_message {
+public:
+    wire_message() : view(nullptr), view_size(0), pos(0) { }
+    explicit wire_message(std::string data) : buf(std::move(data)), view(nullptr), view_size(0), pos(0) { }
+
+    // a read-only view of n bytes at data, no copy is made; data
+    // has to outlive the message (and its copies)
+    wire_message(const char *data, size_t n) : view(data), view_size(n), pos(0) { }
+
+    bool is_view() const { return view != nullptr; }
+
+    // the encoded data, not available for views
+    const std::string &data() const;
+
+    void put_u8(uint8_t v) { put(&v, sizeof(v)); }
+    void put_u32(uint32_t v) { put(&v, sizeof(v)); }
+    void put_i32(int32_t v) { put(&v, sizeof(v)); }
+    void put_f32(float v) { put(&v, sizeof(v)); }
+    void put_u64(uint64_t v) { put(&v, sizeof(v)); }
+    void put_i64(int64_t v) { put(&v, sizeof(v)); }
+    void put_f64(double v) { put(&v, sizeof(v)); }
+    void put_str(const std::string &str);
+    void put_bytes(const void *data, size_t n) { put(data, n); }
+
+    uint8_t  get_u8() { uint8_t v; get(&v, sizeof(v)); return v; }
+    uint32_t get_u32() { uint32_t v; get(&v, sizeof(v)); return v; }
+    int32_t  get_i32() { int32_t v; get(&v, sizeof(v)); return v; }
+    float    get_f32() { float v; get(&v, sizeof(v)); return v; }
+    uint64_t get_u64() { uint64_t v; get(&v, sizeof(v)); return v; }
+    int64_t  get_i64() { int64_t v; get(&v, sizeof(v)); return v; }
+    double   get_f64() { double v; get(&v, sizeof(v)); return v; }
+    std::string get_str();
+    void get_bytes(void *data, size_t n) { get(data, n); }
+
+    // a u32 count of items that take at least min_size bytes each,
+    // checked against what is left before anyone allocates for it
+    uint32_t get_count(size_t min_size);
+
+    size_t remaining() const { return size() - pos; }
+
+    void put_mode(const monitor::mode &mode);
+    monitor::mode get_mode();
+
+    void put_display(const display &dsy);
+    display get_display();
+
+    void put_monitor(const monitor &monitor);
+    monitor get_monitor();
+
+    void put_rgb2lms(const rgb2lms &rgb2lms);
+    rgb2lms get_rgb2lms();
+
+    void put_subject(const subject &subject);
+    subject get_subject();
+
+private:
+    void put(const void *data, size_t n);
+    void get(void *data, size_t n);
+
+    const char *begin() const { return view != nullptr ? view : buf.data(); }
+    size_t size() const { return view != nullptr ? view_size : buf.size(); }
+
+private:
+    std::string buf;
+    const char *view;
+    size_t view_size;
+    size_t pos;
+};
+
+} //iris::data::
+} //iris::
+
+#endif //IRIS_WIRE_H
@@ -6,11 +6,14 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <serial.h>
 #include <boost/program_options.hpp>
 #include <data.h>
 #include <lpm.h>
+#include <misc.h>
 #include <pr655.h>
+#include <recorder.h>
 
 int main(int argc, char **argv) {
 
@@ -82,7 +85,14 @@ int main(int argc, char **argv) {
 
         std::cout << std::endl << "Starting Process for all available LEDs..." << std::endl << std::endl;
 
-        std::map<uint16_t, spectral_data> spectrumData;
+        /*
+         * spectra are written as they are measured
+         */
+        std::unique_ptr<iris::recorder> rec;
+        if(spectrumFlag) {
+            rec.reset(new iris::recorder("data/spectral-" + iris::make_timestamp() + ".h5"));
+        }
+
         std::ofstream errorOut("data/error.txt");
 
         for(auto elem : ledMap)    {
@@ -144,7 +154,9 @@ int main(int argc, char **argv) {
                     device::pr655::cfg config = meter.config();
                     spectral_data data = meter.spectral();
                     if(could_measure) {
-                        spectrumData.insert( std::pair<uint16_t , spectral_data>(elem.second, data) );
+                        rec->record(data, {{"led", {float(elem.second)}},
+                                           {"pin", {float(elem.first)}},
+                                           {"pwm", {float(ledPwmMap.at(elem.second))}}});
                     } else {
                         std::cout << ">>: Unable to measure spectrum of " << unsigned(elem.second) << "nm LED on pin " << unsigned(elem.first) << " with PWM: " << ledPwmMap.at(elem.second) <<std::endl;
                         errorOut << ">>: Unable to measure spectrum of " << unsigned(elem.second) << "nm LED on pin " << unsigned(elem.first) << " with PWM: " << ledPwmMap.at(elem.second) <<std::endl;
@@ -178,46 +190,14 @@ int main(int argc, char **argv) {
             usleep(1000000);
         }
 
-        if(spectrumFlag) {
-
-            std::ofstream fout("data/spectral.txt");
-
-            fout << "led,";
-
-            for(auto elem : spectrumData)    {
-                spectral_data temp = elem.second;
-
-                for (size_t i = 0; i < temp.data.size(); i++) {
-                    fout << temp.wl_start + i * temp.wl_step ;
-
-                    if(i != (temp.data.size() -1) ) {
-                        fout << ",";
-                    }
-                }
-                break;      // just to print top header line in dump file
-            }
-
-            fout << std::endl;
-
-            for(auto elem : spectrumData)    {
-                fout << unsigned(elem.first) << ",";
-                spectral_data temp = elem.second;
-
-                for (size_t i = 0; i < temp.data.size(); i++) {
-                    fout << temp.data[i] ;
-
-                    if(i != (temp.data.size() -1) ) {
-                        fout << ",";
-                    }
-                }
-                fout << std::endl;
-            }
+        /*
+         * Closing Streams
+         */
+        errorOut.close();
 
-            /*
-             * Closing Streams
-             */
-            errorOut.close();
-            fout.close();
+        if(spectrumFlag) {
+            rec->close();
+            std::cout << rec->rows() << " spectra saved to " << rec->location() << std::endl;
         }
 
     } else {
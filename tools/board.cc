@@ -12,6 +12,7 @@
 #include <random>
 #include <dkl.h>
 #include <misc.h>
+#include <watch.h>
 
 #include <numeric>
 #include <thread>
@@ -283,10 +284,41 @@ int main(int argc, char **argv) {
         wnd.disable_cursor();
     }
 
+    // switch to new calibrations without restarting
+    std::unique_ptr<iris::data::store_watcher> watcher;
+    try {
+        watcher = store.watch();
+        watcher->subscribe([&](const iris::data::store_event &ev) {
+            typedef iris::data::store_event::kind kind;
+
+            if (ev.what == kind::default_monitor) {
+                std::cerr << "[W] default monitor changed, restart to use it" << std::endl;
+                return;
+            } else if ((ev.what != kind::rgb2lms || ev.id != display.monitor_id) && ev.what != kind::store) {
+                return;
+            }
+
+            try {
+                rgb2lms = store.load_rgb2lms(display);
+                cspace = iris::dkl(rgb2lms.dkl_params, iris::rgb::gray(rgb2lms.gray_level));
+                wnd.update_colors();
+                std::cerr << "[I] using calibration: " << rgb2lms.identifier() << std::endl;
+            } catch (const std::exception &e) {
+                std::cerr << "[W] keeping calibration: " << e.what() << std::endl;
+            }
+        });
+    } catch (const std::exception &e) {
+        std::cerr << "[W] not watching the store: " << e.what() << std::endl;
+    }
+
     while (! wnd.should_close()) {
 
         wnd.render();
         glfwPollEvents();
+
+        if (watcher) {
+            watcher->poll();
+        }
     }
 
     glfwTerminate();
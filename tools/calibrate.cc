@@ -1,5 +1,6 @@
 
 #include <h5x/File.hpp>
+#include <h5x/hydra/iris.hpp>
 
 #include <boost/program_options.hpp>
 
@@ -72,6 +73,17 @@ std::vector<double> cmp_luminance(const h5x::File &fd, const iris::spectra &cf,
 
 }
 
+static iris::spectra load_cone_fundamentals(const std::string &cones) {
+    if (!cones.empty()) {
+        std::cerr << "[I] Using cone fundamentals: " << cones << std::endl;
+        return iris::spectra::from_csv(fs::file(cones));
+    }
+
+    iris::data::store store = iris::data::store::default_store();
+    std::cerr << "[I] Using cone fundamentals: " << store.cone_fundamentals(4).path() << std::endl;
+    return store.load_cone_fundamentals(4);
+}
+
 static void save_calibration_to_h5(h5x::File &fd,
                                    std::vector<double> &x,
                                    std::vector<double> &y,
@@ -79,13 +91,9 @@ static void save_calibration_to_h5(h5x::File &fd,
                                    const iris::dkl::parameter & dklp) {
     h5x::Group cag = fd.openGroup("rgb2sml", true);
 
-    h5x::DataSet cai;
     h5x::NDSize cai_dims = {3UL, 3UL, nspec};
-    if (cag.hasData("cone-activations")) {
-        cai = cag.openData("cone-activations");
-    } else {
-        cai = cag.createData("cone-activations", h5x::TypeId::Float, cai_dims);
-    }
+    boost::optional<h5x::DataSet> found = cag.tryOpenData("cone-activations");
+    h5x::DataSet cai = found ? *found : cag.createData("cone-activations", h5x::TypeId::Float, cai_dims);
 
     cai.setExtent(cai_dims);
     cai.write(h5x::TypeId::Double, cai_dims, y.data());
@@ -95,15 +103,64 @@ static void save_calibration_to_h5(h5x::File &fd,
     cag.setData("Azero", dklp.A_zero);
     cag.setData("gamma", dklp.gamma);
 
-    h5x::DataSet caA;
     h5x::NDSize caA_dims = {3, 3};
-    if (cag.hasData("A")) {
-        caA = cag.openData("A");
+    found = cag.tryOpenData("A");
+    h5x::DataSet caA = found ? *found : cag.createData("A", h5x::TypeId::Double, caA_dims);
+
+    caA.write(h5x::TypeId::Double , caA_dims, dklp.A);
+}
+
+static void save_fit_report_to_h5(h5x::Group &parent, const iris::fit_report &report, const std::string &seed) {
+    h5x::Group fg = parent.openGroup("fit", true);
+
+    h5x::AttrMap attrs;
+    attrs.set("seed", seed)
+         .set("success", report.success)
+         .set("info", report.info)
+         .set("iterations", report.iterations)
+         .set("nfev", report.nfev)
+         .set("residual-norm", report.residual_norm)
+         .set("wall-time", report.wall_time);
+    fg.setAttrs(attrs);
+
+    fg.setData("trace", report.trace);
+
+    const size_t n = static_cast<size_t>(std::sqrt(report.covariance.size()));
+    h5x::NDSize cov_dims = {n, n};
+    boost::optional<h5x::DataSet> found = fg.tryOpenData("covariance");
+
+    h5x::DataSet cov;
+    if (found) {
+        cov = *found;
+        cov.setExtent(cov_dims);
     } else {
-        caA = cag.createData("A", h5x::TypeId::Double, caA_dims);
+        cov = fg.createData("covariance", h5x::TypeId::Double, cov_dims);
     }
 
-    caA.write(h5x::TypeId::Double , caA_dims, dklp.A);
+    cov.write(h5x::TypeId::Double, cov_dims, report.covariance.data());
+}
+
+// residual norm of the fit that produced the seed calibration, from
+// the .cac file imported along with it; negative if unknown
+static double seed_residual(const iris::data::store &store, const iris::data::rgb2lms &seed) {
+    fs::file cac = store.location().child("monitors/" + seed.dsy.monitor_id + "/" + seed.identifier() + ".cac");
+    if (!cac.exists()) {
+        return -1.0;
+    }
+
+    try {
+        h5x::File fd = h5x::File::open(cac.path(), "r");
+        if (!fd.hasGroup("rgb2sml") || !fd.openGroup("rgb2sml", false).hasGroup("fit")) {
+            return -1.0;
+        }
+
+        double residual = -1.0;
+        fd.openGroup("rgb2sml", false).openGroup("fit", false).getAttr("residual-norm", residual);
+        return residual;
+    } catch (const std::exception &e) {
+        std::cerr << "[W] could not read fit report of " << cac.path() << ": " << e.what() << std::endl;
+        return -1.0;
+    }
 }
 
 int main(int argc, char **argv) {
@@ -114,6 +171,7 @@ int main(int argc, char **argv) {
     std::string cones;
     double weight_exp = 1.1;
     bool check_lum = false;
+    bool warm_start = false;
     float dsp_width = -1;
     float dsp_height = -1;
 
@@ -125,6 +183,7 @@ int main(int argc, char **argv) {
             ("cone-fundamentals,c", po::value<std::string>(&cones))
             ("weight-exponent,w", po::value<double>(&weight_exp))
             ("check-luminance", po::value<bool>(&check_lum))
+            ("warm-start", po::value<bool>(&warm_start), "start from the latest rgb2lms in the store [default=false]")
             ("width,W", po::value<float>(&dsp_width))
             ("height,H", po::value<float>(&dsp_height))
             ("input", po::value<std::string>(&input)->required())
@@ -162,31 +221,21 @@ int main(int argc, char **argv) {
     }
 
 
-    h5x::DataSet sp = fd.openData("spectra");
-    h5x::DataSet ps = fd.openData("patches");
-
-    h5x::NDSize sp_size = sp.size();
-    h5x::NDSize ps_size = ps.size();
+    // files without wavelength attributes are from the PR655 at 380:4
+    spectra spec;
+    spec.lambda(380, 4);
+    h5x::getSpectra(fd, "spectra", spec);
 
-    spectra spec(sp_size[0], sp_size[1], 380, 4);
+    spectra cf = load_cone_fundamentals(cones);
 
-    sp.read(h5x::TypeId::Float, sp_size, spec.data());
+    std::vector<iris::rgb> stim;
+    fd.getData("patches", stim);
 
-    fs::file cff;
-    if (cones.empty()) {
-        iris::data::store store = iris::data::store::default_store();
-        cff = store.cone_fundamentals(4);
-    } else {
-        cff = fs::file(cones);
+    if (stim.size() != spec.num_spectra()) {
+        std::cerr << "[E] Number of spectra and patches differ" << std::endl;
+        return 1;
     }
 
-    std::cerr << "[I] Using cone fundamentals: " << cff.path() << std::endl;
-
-    spectra cf = iris::spectra::from_csv(cff);
-
-    std::vector<iris::rgb> stim(ps_size[0]);
-    ps.read(h5x::TypeId::Float, ps_size, stim.data());
-
     std::vector<double> y;
     std::vector<double> x;
 
@@ -221,14 +270,8 @@ int main(int argc, char **argv) {
     }
 
 
-    rgb2sml_fitter fitter(x, y, weight_exp);
-    fitter();
-
-    dkl::parameter dklp = fitter.rgb2sml();
-
     std::string tstamp = iris::make_timestamp();
     data::rgb2lms rgb2lms(tstamp);
-    rgb2lms.dkl_params = dklp;
 
     fd.getAttr("gray-level", rgb2lms.gray_level);
     fd.getAttr("display.monitor", rgb2lms.dsy.monitor_id);
@@ -242,6 +285,59 @@ int main(int argc, char **argv) {
     fd.getAttr("mode.depth.g", rgb2lms.dsy.mode.g);
     fd.getAttr("mode.depth.b", rgb2lms.dsy.mode.b);
 
+    rgb2sml_fitter fitter(x, y, weight_exp);
+    std::string seed = "default";
+    double reference = -1.0;
+
+    if (warm_start) {
+        try {
+            iris::data::store store = iris::data::store::default_store();
+            data::rgb2lms previous = store.load_rgb2lms(rgb2lms.dsy);
+            fitter.seed(previous.dkl_params);
+            seed = previous.identifier();
+            reference = seed_residual(store, previous);
+        } catch (const std::exception &e) {
+            std::cerr << "[W] no previous calibration to start from: " << e.what() << std::endl;
+        }
+    }
+
+    std::cerr << "[I] Using start values: " << seed << std::endl;
+
+    fit_report report = fitter.fit();
+    dkl::parameter dklp = fitter.rgb2sml();
+
+    // a warm start that fails, or ends up clearly worse than the fit
+    // it was seeded from (a worse local minimum), gets a cold re-fit
+    const double worse_factor = 1.5;
+    const bool suspect = !report.success || (reference > 0 && report.residual_norm > worse_factor * reference);
+
+    if (seed != "default" && suspect) {
+        std::cerr << "[W] warm-started fit " << (report.success ? "is worse than its seed" : "did not converge");
+        std::cerr << " (|r| = " << report.residual_norm << ", seed |r| = " << reference << ")";
+        std::cerr << ", trying default start values" << std::endl;
+
+        rgb2sml_fitter fallback(x, y, weight_exp);
+        fit_report fb_report = fallback.fit();
+
+        // converged beats failed, then the smaller residual wins
+        bool better = fb_report.success != report.success ? fb_report.success
+                                                          : fb_report.residual_norm < report.residual_norm;
+
+        if (better) {
+            std::cerr << "[I] using default start values (|r| = " << fb_report.residual_norm << ")" << std::endl;
+            report = fb_report;
+            dklp = fallback.rgb2sml();
+            seed = "default";
+        }
+    }
+
+    std::cerr << "[I] fit: " << (report.success ? "converged" : "failed");
+    std::cerr << " (" << report.info << ") after " << report.iterations << " iterations, ";
+    std::cerr << report.nfev << " evaluations, |r| = " << report.residual_norm;
+    std::cerr << " [" << report.wall_time * 1000.0 << " ms]" << std::endl;
+
+    rgb2lms.dkl_params = dklp;
+
     rgb2lms.dataset = input;
 
     rgb2lms.height = dsp_height;
@@ -265,6 +361,8 @@ int main(int argc, char **argv) {
 
     h5x::File caf = h5x::File::open(tstamp + ".cac", "w+");
     save_calibration_to_h5(caf, x, y, nspec, dklp);
+    h5x::Group cag = caf.openGroup("rgb2sml", false);
+    save_fit_report_to_h5(cag, report, seed);
     caf.close();
 
     return 0;
@@ -22,6 +22,7 @@ int main(int argc, char **argv) {
     std::string infile_path;
     bool fit_freq = false;
     bool only_stdout = false;
+    bool with_report = false;
     double offset = -1.0;
 
     po::options_description opts("calibration tool");
@@ -30,6 +31,7 @@ int main(int argc, char **argv) {
             ("fit-frequency", po::value<bool>(&fit_freq), "also fit sin frequency [default=false]")
             ("offset", po::value<double>(&offset), "fix the offset [default=fit it]")
             ("file", po::value<std::string>(&infile_path)->required())
+            ("report", po::value<bool>(&with_report), "add the fit report to the output [default=false]")
             ("stdout", po::value<bool>(&only_stdout));
 
     po::positional_options_description pos;
@@ -51,8 +53,7 @@ int main(int argc, char **argv) {
     }
 
     fs::file fd(infile_path);
-    std::string raw = fd.read_all();
-    iris::data::isodata input = iris::data::store::yaml2isodata(raw);
+    iris::data::isodata input = iris::data::store::load_isodata(fd);
 
     std::vector<double> x(input.samples.size());
     std::vector<double> y(input.samples.size());
@@ -67,9 +68,13 @@ int main(int argc, char **argv) {
                    });
 
     iris::sin_fitter fitter(x, y, fit_freq, offset);
-    bool res = fitter();
+    iris::fit_report report = fitter.fit();
+    bool res = report.success;
 
     std::cerr << "success: " << res << std::endl;
+    std::cerr << "[I] fit: " << report.iterations << " iterations, ";
+    std::cerr << report.nfev << " evaluations, |r| = " << report.residual_norm;
+    std::cerr << " [" << report.wall_time * 1000.0 << " ms]" << std::endl;
     std::cout << fitter.amplitude() << " " << fitter.phase() << " ";
     std::cout << fitter.offset() << (offset < 0 ? " " : "* ");
     std::cout << fitter.frequency() << (fit_freq ? " " : "* ");
@@ -87,6 +92,9 @@ int main(int argc, char **argv) {
         std::cerr << "[I] rgb2lms: " << iso.rgb2lms << std::endl;
 
         std::string outdata = iris::data::store::isoslant2yaml(iso);
+        if (with_report) {
+            outdata += "\n" + iris::data::store::fit_report2yaml(report);
+        }
         if (only_stdout) {
             std::cout << outdata << std::endl;
         } else {
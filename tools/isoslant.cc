@@ -23,12 +23,26 @@
 #include <random>
 #include <scene.h>
 #include <fit.h>
+#include <watch.h>
 
 namespace gl = glue;
 
+// criterion to end the session before all trials are done
+struct early_stop {
+    size_t block;      // only check after complete blocks
+    size_t min_blocks; // ... and not before that many
+    double dl_ci;      // max 95% CI half-width for dl (<= 0: disabled)
+    double phi_ci;     // max 95% CI half-width for phi [rad]
+
+    bool enabled() const {
+        return dl_ci > 0 || phi_ci > 0;
+    }
+};
+
 class flicker_wnd : public gl::window {
 public:
-    flicker_wnd(const iris::data::rgb2lms &rgb2lms, const std::vector<double> &stimuli, int refresh);
+    flicker_wnd(const iris::data::rgb2lms &rgb2lms, const std::vector<double> &stimuli, int refresh,
+                const early_stop &stop);
     void render();
 
     virtual void key_event(int key, int scancode, int action, int mods) override;
@@ -54,6 +68,10 @@ public:
         return resp;
     }
 
+    const std::vector<iris::data::isodata::estimate>& trace() const {
+        return estimates;
+    }
+
     void update_label();
 
 private:
@@ -79,12 +97,19 @@ private:
 
     bool completed;
     std::vector<double> resp;
+
+    early_stop stop;
+    iris::sin_accumulator acc;
+    std::vector<iris::data::isodata::estimate> estimates;
+
+    bool update_estimate();
 };
 
-flicker_wnd::flicker_wnd(const iris::data::rgb2lms &rgb2lms, const std::vector<double> &stimuli, int refresh)
+flicker_wnd::flicker_wnd(const iris::data::rgb2lms &rgb2lms, const std::vector<double> &stimuli, int refresh,
+                         const early_stop &stop)
         : window(rgb2lms.dsy, "iris - isoslant"),
           dkl(rgb2lms.dkl_params, iris::rgb::gray(rgb2lms.gray_level)),
-          phi(stimuli), refresh(refresh), nframes(0) {
+          phi(stimuli), refresh(refresh), nframes(0), stop(stop) {
 
     make_current_context();
     glfwSwapInterval(1);
@@ -114,7 +139,7 @@ flicker_wnd::flicker_wnd(const iris::data::rgb2lms &rgb2lms, const std::vector<d
     mouse_gain = 0.00001;
     completed = false;
 
-    resp.resize(phi.size());
+    resp.reserve(phi.size());
 
     fg_angle(phi[stim_index]);
 
@@ -141,6 +166,35 @@ void flicker_wnd::update_label() {
     progress.text(sstr.str());
 }
 
+// feed the latest response into the running fit; returns true
+// if the session can end because the estimate is precise enough
+bool flicker_wnd::update_estimate() {
+    const size_t n = resp.size();
+    acc.add(phi[n - 1], resp[n - 1]);
+
+    if (!acc.solve()) {
+        return false;
+    }
+
+    iris::data::isodata::estimate e;
+    e.trial = n;
+    e.dl = acc.amplitude();
+    e.phi = acc.phase();
+    e.dl_ci = 1.96 * acc.amplitude_error();
+    e.phi_ci = 1.96 * acc.phase_error();
+    estimates.push_back(e);
+
+    std::cerr << "[I] estimate: dl " << e.dl << " ± " << e.dl_ci;
+    std::cerr << ", phi " << e.phi << " ± " << e.phi_ci << std::endl;
+
+    if (!stop.enabled() || n % stop.block != 0 || n / stop.block < stop.min_blocks) {
+        return false;
+    }
+
+    return (stop.dl_ci <= 0 || e.dl_ci < stop.dl_ci) &&
+           (stop.phi_ci <= 0 || e.phi_ci < stop.phi_ci);
+}
+
 void flicker_wnd::render() {
     nframes++;
 
@@ -183,14 +237,20 @@ void flicker_wnd::key_event(int key, int scancode, int action, int mods) {
         const double phi_adjusted = dkl.reference_gray().r;
         const double idx = stim_index++;
 
-        resp[idx] = phi_adjusted;
+        resp.push_back(phi_adjusted);
 
         std::cerr << phi[idx] << ", " << phi_adjusted << std::endl;
 
+        bool converged = update_estimate();
+
         //reset reference point
         dkl.reference_gray(iris::rgb::gray(gray_level));
 
-        if (stim_index < phi.size()) {
+        if (converged) {
+            std::cerr << "[I] estimate converged after " << stim_index << " trials" << std::endl;
+            completed = true;
+            should_close(true);
+        } else if (stim_index < phi.size()) {
             fg_angle(phi[stim_index]);
         } else {
             completed = true;
@@ -223,6 +283,7 @@ int main(int argc, char **argv) {
         size_t N = 16;
         size_t R = 4;
         double contrast = 0.16;
+        early_stop stop = {0, 2, -1.0, -1.0};
         bool use_stdout = false;
         std::string sid;
 
@@ -232,6 +293,9 @@ int main(int argc, char **argv) {
                 ("number,n", po::value<size_t>(&N), "number of colors to sample [default=16")
                 ("repetition,r", po::value<size_t>(&R), "number of repetitions [default=4]")
                 ("contrast,c", po::value<double>(&contrast)->required())
+                ("stop-dl", po::value<double>(&stop.dl_ci), "stop once the 95% CI of dl is below [default=off]")
+                ("stop-phi", po::value<double>(&stop.phi_ci), "stop once the 95% CI of phi is below [default=off]")
+                ("min-blocks", po::value<size_t>(&stop.min_blocks), "blocks before stopping early [default=2]")
                 ("stdout", po::value<bool>(&use_stdout))
                 ("subject,S", po::value<std::string>(&sid)->required());
 
@@ -276,6 +340,8 @@ int main(int argc, char **argv) {
         std::mt19937 rnd_gen(rnd_dev());
         iris::block_shuffle(stim.begin(), stim.end(), N, rnd_gen);
 
+        stop.block = N;
+
         // figure out how many frames roughly corresponds to 20Hz
         double rk = mode.refresh / 20.0;
         int refresh = static_cast<int>(std::round(rk));
@@ -283,7 +349,7 @@ int main(int argc, char **argv) {
         std::cerr << "[I] refresh: " << (mode.refresh / refresh) << " Hz ";
         std::cerr << " nf: " << refresh << " (" << rk << ")" << std::endl;
 
-        flicker_wnd wnd(rgb2lms, stim, refresh);
+        flicker_wnd wnd(rgb2lms, stim, refresh, stop);
 
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -294,8 +360,27 @@ int main(int argc, char **argv) {
         std::cerr << "[I] gray-level: " << gray_level << std::endl;
         std::cerr << store.rgb2lms2yaml(rgb2lms) << std::endl;
 
+        // a session must not mix calibrations, but let the
+        // operator know that this one is no longer the latest
+        std::unique_ptr<iris::data::store_watcher> watcher;
+        try {
+            watcher = store.watch();
+            watcher->subscribe([&](const iris::data::store_event &ev) {
+                if (ev.what == iris::data::store_event::kind::rgb2lms && ev.id == display.monitor_id) {
+                    std::cerr << "[W] new calibration " << ev.name << " for this display, ";
+                    std::cerr << "session continues with " << rgb2lms.identifier() << std::endl;
+                }
+            });
+        } catch (const std::exception &e) {
+            std::cerr << "[W] not watching the store: " << e.what() << std::endl;
+        }
+
         while (!wnd.should_close()) {
            wnd.render();
+
+           if (watcher) {
+               watcher->poll();
+           }
         }
 
         if (wnd.success()) {
@@ -311,6 +396,7 @@ int main(int argc, char **argv) {
                 iso.samples[i].response = static_cast<float>(y[i]);
             }
 
+            iso.trace = wnd.trace();
             iso.display = display;
             iso.rgb2lms = rgb2lms.identifier();
 
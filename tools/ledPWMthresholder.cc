@@ -9,7 +9,9 @@
 #include <boost/program_options.hpp>
 #include <data.h>
 #include <lpm.h>
+#include <misc.h>
 #include <pr655.h>
+#include <recorder.h>
 
 int main(int argc, char **argv) {
 
@@ -53,7 +55,10 @@ int main(int argc, char **argv) {
 
         std::cout << std::endl << "Starting Thresholding Process for all available LEDs..." << std::endl << std::endl;
 
-        std::map<uint16_t, spectral_data> spectrumData;
+        /*
+         * every spectrum measured along the way is written as it comes in
+         */
+        iris::recorder rec("spectral-" + iris::make_timestamp() + ".h5");
 
         std::map<uint16_t, uint16_t> led_pin_pwm;
 
@@ -122,15 +127,18 @@ int main(int argc, char **argv) {
                         float diff = fabs(maxima - threshold);
                         std::cout << "Difference in Threshold and Peak: " << diff << std::endl;
 
+                        rec.record(data, {{"led", {float(elem.second)}},
+                                          {"pin", {float(elem.first)}},
+                                          {"pwm", {float(previousPWMVal)}},
+                                          {"peak", {maxima}}});
+
                         if( diff  < 0.000005 || previousPWMVal < 1000) {        // it's ok now if diff is less than specified value or PWM gets lower than 1000
                             currentLedThresholdFlag = true;
                             led_pin_pwm.insert(std::pair<uint16_t, uint16_t>(elem.second, previousPWMVal));
-                            spectrumData.insert( std::pair<uint16_t , spectral_data>(elem.second, data) );
                             previousPWMVal = 4096;
                         } else {
                             previousPWMVal = previousPWMVal - pwmDecrementStepSize;
                         }
-                        spectrumData.insert( std::pair<uint16_t , spectral_data>(elem.second, data) );
 
                     } catch (const std::exception &e) {
                         std::cerr << e.what() << std::endl;
@@ -169,40 +177,8 @@ int main(int argc, char **argv) {
         }
         pwmout.close();
 
-        std::ofstream fout("spectral.txt");
-
-        fout << "LED,";
-
-        for(auto elem : spectrumData)    {
-            spectral_data temp = elem.second;
-
-            for (size_t i = 0; i < temp.data.size(); i++) {
-                fout << temp.wl_start + i * temp.wl_step ;
-
-                if(i != (temp.data.size() -1) ) {
-                    fout << ",";
-                }
-            }
-            break;      // just to print top header line in dump file
-        }
-
-        fout << std::endl;
-
-        for(auto elem : spectrumData)    {
-            fout << unsigned(elem.first) << ",";
-            spectral_data temp = elem.second;
-
-            for (size_t i = 0; i < temp.data.size(); i++) {
-                fout << temp.data[i] ;
-
-                if(i != (temp.data.size() -1) ) {
-                    fout << ",";
-                }
-            }
-            fout << std::endl;
-        }
-
-        fout.close();
+        rec.close();
+        std::cout << rec.rows() << " spectra saved to " << rec.location() << std::endl;
 
     } else {
         std::cout << "Not Enough Arguments. call --help for help" << std::endl;
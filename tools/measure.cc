@@ -1,7 +1,6 @@
 
-#include <h5x/File.hpp>
-
 #include <pr655.h>
+#include <recorder.h>
 
 #include <iris.h>
 
@@ -179,8 +178,9 @@ static void check_gl_error(const std::string &prefix = "") {
 class robot : public looper, public gl::window {
 public:
 
-    robot(const iris::data::display &display, device::pr655 &meter, std::vector<iris::rgb> &stim, float gray_level)
-            : gl::window(display, "iris - measure"), meter(meter), stim(stim), gray_level(gray_level) {
+    robot(const iris::data::display &display, device::pr655 &meter, iris::recorder &rec,
+          std::vector<iris::rgb> &stim, float gray_level)
+            : gl::window(display, "iris - measure"), meter(meter), rec(rec), stim(stim), gray_level(gray_level) {
         make_current_context();
         setup();
     }
@@ -229,6 +229,10 @@ public:
 
         device::pr655::response<device::pr655::brightness> br = meter.brightness_pm();
 
+        const iris::rgb &patch = stim[pos - 1];
+        rec.record(data, {{"patches",   {patch.r, patch.g, patch.b}},
+                          {"luminance", {br.data.Y}}});
+
         lum.push_back(br.data.Y);
         resp.push_back(data);
         std::cerr << " done" << std::endl;
@@ -313,6 +317,7 @@ private:
     gl::vertex_array va;
 
     device::pr655 &meter;
+    iris::recorder &rec;
 
     // state
     gl::color::rgba color;
@@ -366,69 +371,27 @@ void dump_stdout(const robot &r) {
     std::cout.unsetf(std::ios_base::floatfield);
 }
 
-void save_data_h5(const std::string &path,
-                  const robot &r,
-                  const iris::data::display &display,
-                  float gray_level,
-                  device::pr655 &meter) {
-
-    const std::vector<iris::rgb> &stim = r.stimulation();
-    const std::vector<spectral_data> &resp = r.spectra();
-
-    if (resp.empty()) {
-        std::cout << "[W] No data!" << std::endl;
-        return;
-    }
-
-    size_t nwl = resp[0].data.size();
-
-    h5x::NDSize dims = {resp.size(), nwl};
-    h5x::File fd = h5x::File::open(path, "a");
-    h5x::DataSet ds;
-    if (!fd.hasData("spectra")) {
-        ds = fd.createData("spectra", h5x::TypeId::Float, dims);
-    } else {
-        ds = fd.openData("spectra");
-    }
-
-    for(size_t i = 0; i < resp.size(); i++) {
-        const std::vector<float> data = resp[i].data;
-        h5x::Selection memSel(data);
-        h5x::Selection fileSel(ds.getSpace());
-        h5x::NDSize count = {static_cast<size_t>(1), nwl};
-        h5x::NDSize offset = {i, static_cast<size_t>(0)};
-        fileSel.select(count, offset);
-        ds.write(h5x::TypeId::Float, data.data(), fileSel, memSel);
-    }
-
-    ds.setAttr("wl_start", resp[0].wl_start);
-    ds.setAttr("wl_step", resp[0].wl_step);
-
-    if (! fd.hasData("patches")) {
-        h5x::NDSize dc = {stim.size(), static_cast<size_t>(3)};
-        h5x::DataSet patches;
-        patches = fd.createData("patches", h5x::TypeId::Float, dc);
-        patches.setExtent(dc);
-        patches.write(h5x::TypeId::Float, dims, static_cast<const void *>(stim.data()));
-    }
-
-    fd.setData("luminance", r.luminance());
-    fd.setAttr("display.monitor", display.monitor_id);
-    fd.setAttr("display.link", display.link_id);
-    fd.setAttr("display.settings", display.settings_id);
-    fd.setAttr("display.gfx", display.gfx);
-    fd.setAttr("mode.height", display.mode.height);
-    fd.setAttr("mode.width", display.mode.width);
-    fd.setAttr("mode.refresh", display.mode.refresh);
-    fd.setAttr("mode.depth.r", display.mode.r);
-    fd.setAttr("mode.depth.g", display.mode.g);
-    fd.setAttr("mode.depth.b", display.mode.b);
-    fd.setAttr("gray-level", gray_level);
-    fd.setAttr("meter.model", meter.model_number());
-    fd.setAttr("meter.serial", meter.serial_number());
-
-    ds.close();
-    fd.close();
+void save_metadata(iris::recorder &rec,
+                   const iris::data::display &display,
+                   float gray_level,
+                   device::pr655 &meter) {
+
+    h5x::AttrMap attrs;
+    attrs.set("display.monitor", display.monitor_id)
+         .set("display.link", display.link_id)
+         .set("display.settings", display.settings_id)
+         .set("display.gfx", display.gfx)
+         .set("mode.height", display.mode.height)
+         .set("mode.width", display.mode.width)
+         .set("mode.refresh", display.mode.refresh)
+         .set("mode.depth.r", display.mode.r)
+         .set("mode.depth.g", display.mode.g)
+         .set("mode.depth.b", display.mode.b)
+         .set("gray-level", gray_level)
+         .set("meter.model", meter.model_number())
+         .set("meter.serial", meter.serial_number());
+
+    rec.attrs(attrs);
 }
 
 std::vector<iris::rgb> read_color_list(std::string path) {
@@ -549,7 +512,13 @@ int main(int argc, char **argv)
 
     // *****
 
-    robot bender(display, meter, colors, gray_level);
+    // measurements are written as they come in, and can be followed
+    // with h5x::File::open(fn, "rs") while the session runs
+    const std::string fn = "spectra-" + iris::make_timestamp() + ".h5";
+    iris::recorder rec(fn, iris::recorder::mode::live);
+    save_metadata(rec, display, gray_level, meter);
+
+    robot bender(display, meter, rec, colors, gray_level);
 
     // **
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
@@ -578,11 +547,11 @@ int main(int argc, char **argv)
 
 
     dump_stdout(bender);
-    const std::string fn = "spectra-" + iris::make_timestamp() + ".h5";
-    save_data_h5(fn, bender, display, gray_level, meter);
 
     meter.stop();
     bender.stop();
+    rec.close();
+    std::cerr << "[I] " << rec.rows() << " measurements in " << rec.location() << std::endl;
     bender = nullptr;
 
     std::cerr << "Goodbay. Have a nice day!" << std::endl;
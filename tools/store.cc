@@ -2,10 +2,19 @@
 
 #include <boost/program_options.hpp>
 #include <data.h>
+#include <pack.h>
+#include <record.h>
+
+#include <h5x/File.hpp>
 
 #include <getopt.h>
 
+#include <algorithm>
+#include <ctime>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
 #include <yaml-cpp/yaml.h>
 
 static int cmd_info(int argc, char **argv) {
@@ -13,10 +22,26 @@ static int cmd_info(int argc, char **argv) {
 
     std::cout << "location: " << store.location().path() << std::endl;
     std::cout << "version: " << store.version_string() << std::endl;
+    std::cout << "service: " << (store.is_served() ? "iris-stored" : "none") << std::endl;
+
+    std::shared_ptr<const iris::data::store_pack> pack = store.snapshot();
+    if (pack) {
+        std::cout << "snapshot: " << pack->location().path() << " [" << pack->size() << " entries]" << std::endl;
+    } else {
+        std::cout << "snapshot: none" << std::endl;
+    }
 
     return 0;
 }
 
+static const char *copy_mode_name(fs::copy_mode how) {
+    switch (how) {
+        case fs::copy_mode::link:  return "linked to identical data in store";
+        case fs::copy_mode::clone: return "cloned";
+        default:                   return "copied";
+    }
+}
+
 static int import_rgb2lms(iris::data::store &store,
                           fs::file &fd,
                           const std::string &data) {
@@ -26,6 +51,8 @@ static int import_rgb2lms(iris::data::store &store,
     fs::file base = f_imported.parent();
     std::cerr << "[I] stored rgb2lms data [" << rgb2lms.identifier() << "]" << std::endl;
 
+    const std::string mdir = "monitors/" + rgb2lms.dsy.monitor_id + "/";
+
     std::string root, ext;
 
     std::tie(root, ext) = fd.splitext();
@@ -39,8 +66,8 @@ static int import_rgb2lms(iris::data::store &store,
         if (dest.exists()) {
             std::cerr << "[W] cac already exists. skipping!" << std::endl;
         } else {
-            cac.copy(dest);
-            std::cerr << "[I] cac file imported!" << std::endl;
+            fs::copy_mode how = store.import_file(cac, mdir + cac.name());
+            std::cerr << "[I] cac file imported (" << copy_mode_name(how) << ")!" << std::endl;
         }
     }
 
@@ -50,8 +77,8 @@ static int import_rgb2lms(iris::data::store &store,
         if (dest.exists()) {
             std::cerr << "[W] spectral data file already exists. skipping! " << std::endl;
         } else {
-            cac.copy(dest);
-            std::cerr << "[I] spectral data imported!" << std::endl;
+            fs::copy_mode how = store.import_file(msd, mdir + msd.name());
+            std::cerr << "[I] spectral data imported (" << copy_mode_name(how) << ")!" << std::endl;
         }
     }
 
@@ -102,6 +129,748 @@ static int cmd_import(int argc, char **argv) {
     return 0;
 }
 
+static int cmd_find(int argc, char **argv) {
+    iris::data::store store = iris::data::store::default_store();
+
+    static struct option longopts[] = {
+            { "prefix",      no_argument,            NULL,           'p' },
+            { "ignore-case", no_argument,            NULL,           'i' },
+            { NULL,          0,                      NULL,           0 }
+    };
+
+    int how = iris::data::subject_index::exact;
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "pi", longopts, NULL)) != -1)
+        switch (ch) {
+            case 'p':
+                how |= iris::data::subject_index::prefix;
+                break;
+
+            case 'i':
+                how |= iris::data::subject_index::ignore_case;
+                break;
+
+            case '?':
+            default:
+                std::cerr << "unkown option" << std::endl;
+                std::cerr << "usage: find [-p] [-i] <phrase>" << std::endl;
+                return -1;
+        }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1) {
+        std::cerr << "usage: find [-p] [-i] <phrase>" << std::endl;
+        return -1;
+    }
+
+    std::vector<iris::data::subject> hits = store.find_subjects(argv[0], how);
+
+    for (const iris::data::subject &s : hits) {
+        std::cout << s.identifier() << "\t" << s.initials << "\t" << s.name << std::endl;
+    }
+
+    return hits.empty() ? 1 : 0;
+}
+
+template<typename T>
+static int write_record(const T &obj, std::string (*to_yaml)(const T &), fs::file &out, bool check) {
+    std::string rec = iris::data::encode_record(obj);
+
+    // the emitted YAML must survive the binary round trip
+    if (check) {
+        T back;
+        iris::data::decode_record(iris::data::record_reader(rec), back);
+
+        if (to_yaml(back) != to_yaml(obj)) {
+            std::cerr << "[E] record round trip mismatch for: " << obj.identifier() << std::endl;
+            return 1;
+        }
+
+        std::cerr << "[I] round trip ok [" << rec.size() << " bytes]" << std::endl;
+    }
+
+    out.write_all(rec);
+    return 0;
+}
+
+template<typename T>
+static std::string record2yaml(const iris::data::record_reader &rec, std::string (*to_yaml)(const T &)) {
+    T obj;
+    iris::data::decode_record(rec, obj);
+    return to_yaml(obj);
+}
+
+static int cmd_record(int argc, char **argv) {
+    typedef iris::data::store store;
+
+    static struct option longopts[] = {
+            { "check",       no_argument,            NULL,           'c' },
+            { "dump",        no_argument,            NULL,           'd' },
+            { NULL,          0,                      NULL,           0 }
+    };
+
+    bool check = false;
+    bool dump = false;
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "cd", longopts, NULL)) != -1)
+        switch (ch) {
+            case 'c':
+                check = true;
+                break;
+
+            case 'd':
+                dump = true;
+                break;
+
+            case '?':
+            default:
+                std::cerr << "unkown option" << std::endl;
+                std::cerr << "usage: record [--check] <object> [<output>] | --dump <record>" << std::endl;
+                return -1;
+        }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 1 || argc > (dump ? 1 : 2)) {
+        std::cerr << "usage: record [--check] <object> [<output>] | --dump <record>" << std::endl;
+        return -1;
+    }
+
+    fs::file fd(argv[0]);
+    std::string data = fd.read_all();
+
+    if (dump) {
+        iris::data::record_reader rec(data);
+        typedef iris::data::record_type rt;
+
+        switch (rec.type()) {
+            case rt::monitor:  std::cout << record2yaml(rec, &store::monitor2yaml); break;
+            case rt::rgb2lms:  std::cout << record2yaml(rec, &store::rgb2lms2yaml); break;
+            case rt::subject:  std::cout << record2yaml(rec, &store::subject2yaml); break;
+            case rt::isoslant: std::cout << record2yaml(rec, &store::isoslant2yaml); break;
+            case rt::isodata:  std::cout << record2yaml(rec, &store::isodata2yaml); break;
+            default:
+                std::cerr << "[E] unknown record type" << std::endl;
+                return 1;
+        }
+
+        std::cout << std::endl;
+        return 0;
+    }
+
+    fs::file out(argc > 1 ? argv[1] : fd.path() + ".rec");
+
+    YAML::Node doc = YAML::Load(data);
+    std::string entity = doc.begin()->first.as<std::string>();
+
+    if (entity == "monitor") {
+        return write_record(store::yaml2monitor(data), &store::monitor2yaml, out, check);
+    } else if (entity == "rgb2lms") {
+        return write_record(store::yaml2rgb2lms(data), &store::rgb2lms2yaml, out, check);
+    } else if (entity == "subject") {
+        return write_record(store::yaml2subject(data), &store::subject2yaml, out, check);
+    } else if (entity == "isoslant") {
+        return write_record(store::yaml2isoslant(data), &store::isoslant2yaml, out, check);
+    } else if (entity == "isodata") {
+        return write_record(store::yaml2isodata(data), &store::isodata2yaml, out, check);
+    }
+
+    std::cerr << "[E] cannot make a record of: " << entity << std::endl;
+    return 1;
+}
+
+/* columnar export
+ *
+ *  All sessions (.isodata) and fits (.isoslant) go into one HDF5
+ *  file, one 1-d dataset per column:
+ *     / sessions / id, subject, monitor, settings, gfx, rgb2lms,
+ *                  time, first, trials, source
+ *     / trials   / session, trial, stimulus, response
+ *     / isoslant / id, subject, monitor, settings, rgb2lms, dl, phi, source
+ *     / exported / path, size, mtime
+ *
+ *  trials/session is the row in sessions, sessions/first and
+ *  sessions/trials the slice of trials belonging to the session.
+ *  The "rows" attribute of the file holds the row count of each
+ *  group and is written last; rows past it are left-overs of an
+ *  interrupted export and are dropped.
+ */
+
+enum export_table { et_sessions = 0, et_trials, et_isoslant, et_exported, et_count };
+static const char *export_tables[et_count] = { "sessions", "trials", "isoslant", "exported" };
+
+struct export_batch {
+    std::vector<iris::data::isodata> sessions;
+    std::vector<std::string> session_sources;
+
+    std::vector<iris::data::isoslant> fits;
+    std::vector<std::string> fit_sources;
+
+    std::vector<std::string> paths;
+    std::vector<uint64_t> sizes;
+    std::vector<int64_t> mtimes;
+};
+
+template<typename T>
+static void export_column(const h5x::Group &g, const std::string &name,
+                          const std::vector<T> &values, uint64_t offset) {
+    const h5x::TypeId dtype = h5x::to_type_id<T>::value;
+
+    boost::optional<h5x::DataSet> found = g.tryOpenData(name);
+
+    h5x::DataSet ds;
+    if (found) {
+        ds = *found;
+    } else {
+        h5x::DataType ftype = h5x::data_type_to_h5_filetype(dtype);
+        ds = g.createData(name, ftype, {0}, {}, {4096}, true, false);
+    }
+
+    if (values.empty()) {
+        return;
+    }
+
+    ds.setExtent({offset + values.size()});
+    ds.writeRows(dtype, values.data(), offset, values.size());
+}
+
+static void export_rollback(const h5x::Group &g, uint64_t rows) {
+    for (h5x::ndsize_t i = 0; i < g.objectCount(); i++) {
+        boost::optional<h5x::DataSet> ds = g.tryOpenData(g.objectName(i));
+        if (ds && ds->size()[0] != rows) {
+            ds->setExtent({rows});
+        }
+    }
+}
+
+// session ids are timestamps (see make_timestamp()), -1 if not
+static int64_t export_time(const std::string &id) {
+    std::tm tm = {};
+    const char *end = strptime(id.c_str(), "%Y%m%dT%H%M", &tm);
+
+    if (end == nullptr || *end != '\0') {
+        return -1;
+    }
+
+    tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&tm));
+}
+
+static void export_sessions(const h5x::File &fd, const export_batch &batch, std::vector<uint64_t> &rows) {
+    h5x::Group sg = fd.openGroup("sessions");
+    h5x::Group tg = fd.openGroup("trials");
+
+    std::vector<std::string> id, subject, monitor, settings, gfx, rgb2lms;
+    std::vector<int64_t> time;
+    std::vector<uint64_t> first;
+    std::vector<uint32_t> trials;
+
+    std::vector<uint32_t> session, trial;
+    std::vector<float> stimulus, response;
+
+    for (size_t i = 0; i < batch.sessions.size(); i++) {
+        const iris::data::isodata &d = batch.sessions[i];
+
+        id.push_back(d.identifier());
+        subject.push_back(d.subject);
+        monitor.push_back(d.display.monitor_id);
+        settings.push_back(d.display.settings_id);
+        gfx.push_back(d.display.gfx);
+        rgb2lms.push_back(d.rgb2lms);
+        time.push_back(export_time(d.identifier()));
+        first.push_back(rows[et_trials] + stimulus.size());
+        trials.push_back(static_cast<uint32_t>(d.samples.size()));
+
+        for (size_t k = 0; k < d.samples.size(); k++) {
+            session.push_back(static_cast<uint32_t>(rows[et_sessions] + i));
+            trial.push_back(static_cast<uint32_t>(k));
+            stimulus.push_back(d.samples[k].stimulus);
+            response.push_back(d.samples[k].response);
+        }
+    }
+
+    export_column(tg, "session", session, rows[et_trials]);
+    export_column(tg, "trial", trial, rows[et_trials]);
+    export_column(tg, "stimulus", stimulus, rows[et_trials]);
+    export_column(tg, "response", response, rows[et_trials]);
+
+    export_column(sg, "id", id, rows[et_sessions]);
+    export_column(sg, "subject", subject, rows[et_sessions]);
+    export_column(sg, "monitor", monitor, rows[et_sessions]);
+    export_column(sg, "settings", settings, rows[et_sessions]);
+    export_column(sg, "gfx", gfx, rows[et_sessions]);
+    export_column(sg, "rgb2lms", rgb2lms, rows[et_sessions]);
+    export_column(sg, "time", time, rows[et_sessions]);
+    export_column(sg, "first", first, rows[et_sessions]);
+    export_column(sg, "trials", trials, rows[et_sessions]);
+    export_column(sg, "source", batch.session_sources, rows[et_sessions]);
+
+    rows[et_trials] += stimulus.size();
+    rows[et_sessions] += id.size();
+}
+
+static void export_fits(const h5x::File &fd, const export_batch &batch, std::vector<uint64_t> &rows) {
+    h5x::Group ig = fd.openGroup("isoslant");
+
+    std::vector<std::string> id, subject, monitor, settings, rgb2lms;
+    std::vector<double> dl, phi;
+
+    for (const iris::data::isoslant &iso : batch.fits) {
+        id.push_back(iso.identifier());
+        subject.push_back(iso.subject);
+        monitor.push_back(iso.display.monitor_id);
+        settings.push_back(iso.display.settings_id);
+        rgb2lms.push_back(iso.rgb2lms);
+        dl.push_back(iso.dl);
+        phi.push_back(iso.phi);
+    }
+
+    export_column(ig, "id", id, rows[et_isoslant]);
+    export_column(ig, "subject", subject, rows[et_isoslant]);
+    export_column(ig, "monitor", monitor, rows[et_isoslant]);
+    export_column(ig, "settings", settings, rows[et_isoslant]);
+    export_column(ig, "rgb2lms", rgb2lms, rows[et_isoslant]);
+    export_column(ig, "dl", dl, rows[et_isoslant]);
+    export_column(ig, "phi", phi, rows[et_isoslant]);
+    export_column(ig, "source", batch.fit_sources, rows[et_isoslant]);
+
+    rows[et_isoslant] += id.size();
+}
+
+static std::map<std::string, fs::file::status> export_ledger(const h5x::File &fd, uint64_t n) {
+    std::map<std::string, fs::file::status> ledger;
+
+    if (n == 0) {
+        return ledger;
+    }
+
+    h5x::Group eg = fd.openGroup("exported");
+
+    std::vector<std::string> paths(n);
+    std::vector<uint64_t> sizes(n);
+    std::vector<int64_t> mtimes(n);
+
+    eg.openData("path").read(h5x::TypeId::String, {n}, paths.data());
+    eg.openData("size").read(h5x::TypeId::UInt64, {n}, sizes.data());
+    eg.openData("mtime").read(h5x::TypeId::Int64, {n}, mtimes.data());
+
+    for (size_t i = 0; i < n; i++) {
+        ledger[paths[i]] = fs::file::status{sizes[i], mtimes[i]};
+    }
+
+    return ledger;
+}
+
+// files and directories (recursively, symlinks to directories are not
+// followed) to export; returns the number of files found
+static size_t export_collect(const fs::file &fd,
+                             const std::map<std::string, fs::file::status> &ledger,
+                             export_batch &batch) {
+    if (fd.is_directory()) {
+        size_t n = 0;
+        for (const fs::dir_entry &e : fs::scan(fd, fs::fn_matcher("*"), fs::scan_order::ascending)) {
+            fs::file child = fd.child(e.name);
+
+            if (e.type != fs::dir_entry::kind::symlink && e.is_directory(fd)) {
+                n += export_collect(child, ledger, batch);
+                continue;
+            }
+
+            std::string ext = child.splitext().second;
+            if (ext == "isodata" || ext == "isoslant") {
+                n += export_collect(child, ledger, batch);
+            }
+        }
+        return n;
+    }
+
+    const std::string &path = fd.path();
+    fs::file::status st = fd.stat();
+
+    auto it = ledger.find(path);
+    if (it != ledger.end()) {
+        if (it->second.size != st.size || it->second.mtime != st.mtime) {
+            std::cerr << "[W] " << path << " changed since it was exported, skipping! ";
+            std::cerr << "(use --rebuild)" << std::endl;
+        }
+        return 1;
+    }
+
+    if (std::find(batch.paths.begin(), batch.paths.end(), path) != batch.paths.end()) {
+        return 1;
+    }
+
+    try {
+        if (fd.splitext().second == "isoslant") {
+            batch.fits.push_back(iris::data::store::yaml2isoslant(fd.read_all()));
+            batch.fit_sources.push_back(path);
+        } else {
+            batch.sessions.push_back(iris::data::store::load_isodata(fd));
+            batch.session_sources.push_back(path);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "[W] could not load " << path << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    batch.paths.push_back(path);
+    batch.sizes.push_back(st.size);
+    batch.mtimes.push_back(st.mtime);
+    return 1;
+}
+
+static int cmd_export(int argc, char **argv) {
+    iris::data::store store = iris::data::store::default_store();
+
+    static struct option longopts[] = {
+            { "rebuild",     no_argument,            NULL,           'r' },
+            { NULL,          0,                      NULL,           0 }
+    };
+
+    bool rebuild = false;
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "r", longopts, NULL)) != -1)
+        switch (ch) {
+            case 'r':
+                rebuild = true;
+                break;
+
+            case '?':
+            default:
+                std::cerr << "unkown option" << std::endl;
+                std::cerr << "usage: export [--rebuild] <output.h5> [<file or dir>...]" << std::endl;
+                return -1;
+        }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 1) {
+        std::cerr << "usage: export [--rebuild] <output.h5> [<file or dir>...]" << std::endl;
+        return -1;
+    }
+
+    h5x::File fd = h5x::File::open(argv[0], rebuild ? "w+" : "a");
+
+    std::vector<uint64_t> rows;
+    if (!fd.getAttr("rows", rows) || rows.size() != et_count) {
+        rows.assign(et_count, 0);
+    }
+
+    for (int i = 0; i < et_count; i++) {
+        export_rollback(fd.openGroup(export_tables[i], true), rows[i]);
+    }
+
+    std::map<std::string, fs::file::status> ledger = export_ledger(fd, rows[et_exported]);
+    export_batch batch;
+
+    std::vector<fs::file> sources;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            sources.emplace_back(argv[i]);
+        }
+    } else {
+        fs::file subjects = store.location().child("subjects");
+        if (subjects.exists()) {
+            std::copy_if(subjects.children().begin(), subjects.children().end(),
+                         std::back_inserter(sources), [](const fs::file &f) {
+                return f.name() != "." && f.name() != "..";
+            });
+        }
+    }
+
+    for (const fs::file &src : sources) {
+        if (!src.exists()) {
+            std::cerr << "[W] " << src.path() << " does not exist, skipping!" << std::endl;
+        } else if (export_collect(src, ledger, batch) == 0 && argc > 1) {
+            std::cerr << "[W] no isodata or isoslant files in " << src.path() << std::endl;
+        }
+    }
+
+    size_t ntrials = 0;
+    for (const iris::data::isodata &d : batch.sessions) {
+        ntrials += d.samples.size();
+    }
+
+    std::cerr << "[I] exporting " << batch.sessions.size() << " sessions (" << ntrials << " trials), ";
+    std::cerr << batch.fits.size() << " isoslant fits; " << ledger.size() << " files exported before" << std::endl;
+
+    if (batch.paths.empty()) {
+        return 0;
+    }
+
+    export_sessions(fd, batch, rows);
+    export_fits(fd, batch, rows);
+
+    h5x::Group eg = fd.openGroup("exported");
+    export_column(eg, "path", batch.paths, rows[et_exported]);
+    export_column(eg, "size", batch.sizes, rows[et_exported]);
+    export_column(eg, "mtime", batch.mtimes, rows[et_exported]);
+    rows[et_exported] += batch.paths.size();
+
+    // commits all of the above at once
+    fd.setAttr("rows", rows);
+
+    return 0;
+}
+
+static std::string absolute_path(std::string path) {
+    if (fs::file::path_is_absolute(path)) {
+        return path;
+    }
+
+    while (path.compare(0, 2, "./") == 0) {
+        path.erase(0, 2);
+    }
+
+    fs::file cwd = fs::file::current_directory();
+    return path == "." || path.empty() ? cwd.path() : cwd.child(path).path();
+}
+
+// session files are named <kind>-<timestamp>.h5, so name order is time order
+static void aggregate_collect(const fs::file &src, const fs::fn_matcher &match, std::vector<std::string> &files) {
+    if (!src.is_directory()) {
+        files.push_back(absolute_path(src.path()));
+        return;
+    }
+
+    for (const fs::dir_entry &de : fs::scan(src, match, fs::scan_order::ascending)) {
+        if (!de.is_directory(src)) {
+            files.push_back(absolute_path(src.child(de.name).path()));
+        }
+    }
+}
+
+static int cmd_aggregate(int argc, char **argv) {
+    static struct option longopts[] = {
+            { "data",        required_argument,      NULL,           'd' },
+            { "pattern",     required_argument,      NULL,           'p' },
+            { NULL,          0,                      NULL,           0 }
+    };
+
+    const char *usage = "usage: aggregate [--data <name,...>] [--pattern <glob>] <output.h5> <file or dir>...";
+
+    std::string data = "spectra,patches,luminance";
+    std::string pattern = "spectra-*.h5";
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "d:p:", longopts, NULL)) != -1)
+        switch (ch) {
+            case 'd':
+                data = optarg;
+                break;
+
+            case 'p':
+                pattern = optarg;
+                break;
+
+            case '?':
+            default:
+                std::cerr << "unkown option" << std::endl;
+                std::cerr << usage << std::endl;
+                return -1;
+        }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 2) {
+        std::cerr << usage << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> names;
+    std::stringstream ss(data);
+    for (std::string name; std::getline(ss, name, ',');) {
+        if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+
+    if (names.empty()) {
+        std::cerr << usage << std::endl;
+        return -1;
+    }
+
+    const std::string output = absolute_path(argv[0]);
+    const fs::fn_matcher match(pattern);
+
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        aggregate_collect(fs::file(argv[i]), match, files);
+    }
+
+    // the rows every dataset has; sessions missing one, or whose type,
+    // row shape or wavelength range differs from the first session's,
+    // are skipped here, before the output is touched
+    std::vector<std::string> paths;
+    std::vector<uint64_t> first, rows;
+    uint64_t total = 0;
+
+    std::vector<h5x::DataType> types(names.size());
+    std::vector<h5x::NDSize> shapes(names.size());
+    const bool has_spectra = std::find(names.begin(), names.end(), "spectra") != names.end();
+    uint16_t wl_start = 0, wl_step = 0;
+
+    for (const std::string &path : files) {
+        if (path == output) {
+            continue;
+        }
+
+        try {
+            h5x::File fd = h5x::File::open(path, "r");
+            fd.check("could not open");
+
+            std::vector<h5x::DataType> ftypes;
+            std::vector<h5x::NDSize> fshapes;
+
+            h5x::ndsize_t n = std::numeric_limits<h5x::ndsize_t>::max();
+            for (size_t i = 0; i < names.size(); i++) {
+                boost::optional<h5x::DataSet> ds = fd.tryOpenData(names[i]);
+                if (!ds) {
+                    throw std::runtime_error("no " + names[i]);
+                }
+
+                h5x::NDSize dims = ds->size();
+                if (dims.size() == 0) {
+                    throw std::runtime_error(names[i] + " is a scalar");
+                }
+
+                h5x::DataType dtype = H5Dget_type(ds->h5id());
+                dtype.check("could not get the type of " + names[i]);
+
+                n = std::min(n, dims[0]);
+                dims[0] = 0;
+
+                if (types[i].isValid()) {
+                    bool same = dims == shapes[i] &&
+                                h5x::HTri(H5Tequal(dtype.h5id(), types[i].h5id())).check("H5Tequal failed");
+                    if (!same) {
+                        throw std::runtime_error(names[i] + " differs in type or shape from " + paths.front());
+                    }
+                }
+
+                ftypes.push_back(dtype);
+                fshapes.push_back(dims);
+            }
+
+            if (has_spectra) {
+                h5x::DataSet ds = fd.openData("spectra");
+                if (!ds.hasAttr("wl_start") || !ds.hasAttr("wl_step")) {
+                    throw std::runtime_error("spectra has no wavelength range");
+                }
+
+                uint16_t start = 0, step = 0;
+                ds.getAttr("wl_start", start);
+                ds.getAttr("wl_step", step);
+
+                if (paths.empty()) {
+                    wl_start = start;
+                    wl_step = step;
+                } else if (start != wl_start || step != wl_step) {
+                    throw std::runtime_error("wavelength range differs from " + paths.front());
+                }
+            }
+
+            if (paths.empty()) {
+                types = ftypes;
+                shapes = fshapes;
+            }
+
+            paths.push_back(path);
+            first.push_back(total);
+            rows.push_back(n);
+            total += n;
+        } catch (const std::exception &e) {
+            std::cerr << "[W] skipping " << path << ": " << e.what() << std::endl;
+        }
+    }
+
+    if (total == 0) {
+        std::cerr << "[E] no measurements found" << std::endl;
+        return 1;
+    }
+
+    h5x::File fd = h5x::File::open(output, "w");
+
+    for (const std::string &name : names) {
+        std::vector<h5x::VirtualSource> sources;
+        for (size_t i = 0; i < paths.size(); i++) {
+            sources.push_back(h5x::VirtualSource{paths[i], name, rows[i]});
+        }
+
+        h5x::DataSet ds = fd.createVirtual(name, sources);
+
+        if (name == "spectra") {
+            ds.setAttr("wl_start", wl_start);
+            ds.setAttr("wl_step", wl_step);
+        }
+    }
+
+    std::vector<uint32_t> session;
+    session.reserve(total);
+    for (size_t i = 0; i < paths.size(); i++) {
+        session.insert(session.end(), rows[i], static_cast<uint32_t>(i));
+    }
+
+    fd.setData("session", session);
+
+    h5x::Group sg = fd.openGroup("sessions");
+    sg.setData("path", paths);
+    sg.setData("first", first);
+    sg.setData("rows", rows);
+
+    std::cerr << "[I] " << total << " rows of " << paths.size() << " sessions in " << output << std::endl;
+
+    return 0;
+}
+
+static int cmd_pack(int argc, char **argv) {
+    iris::data::store store = iris::data::store::default_store(false);
+
+    static struct option longopts[] = {
+            { NULL,          0,                      NULL,           0 }
+    };
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "", longopts, NULL)) != -1)
+        switch (ch) {
+            case '?':
+            default:
+                std::cerr << "unkown option" << std::endl;
+                std::cerr << "usage: pack [<output>]" << std::endl;
+                return -1;
+        }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc > 1) {
+        std::cerr << "usage: pack [<output>]" << std::endl;
+        return -1;
+    }
+
+    fs::file out = argc > 0 ? fs::file(argv[0]) : store.location().child("cache/store.pack");
+    store.pack(out);
+
+    std::shared_ptr<iris::data::store_pack> pack = iris::data::store_pack::open(out);
+    if (!pack) {
+        std::cerr << "[E] could not read back the pack: " << out.path() << std::endl;
+        return 1;
+    }
+
+    std::cerr << "[I] packed " << pack->size() << " entries into " << out.path();
+    std::cerr << " [" << out.stat().size << " bytes]" << std::endl;
+
+    return 0;
+}
+
 struct command {
     std::string name;
     std::string help;
@@ -115,6 +884,11 @@ struct command {
 command cmds[] = {
         { "info",   "general data store information", cmd_info },
         { "import", "import data [rgb2lms, isoslant, ...] into store ", cmd_import },
+        { "find",   "find subjects by id, initials or name", cmd_find },
+        { "record", "convert objects to binary records (and back)", cmd_record },
+        { "export", "export all sessions and fits into one columnar HDF5 file", cmd_export },
+        { "aggregate", "map the sessions' spectra files into one virtual HDF5 file", cmd_aggregate },
+        { "pack",   "write a read-only snapshot of the store for fast startup", cmd_pack },
         { "",         "", nullptr}
 };
 
@@ -139,7 +913,8 @@ int main(int argc, char **argv)
     std::string binname = argv[0];
 
     int ch;
-    while ((ch = getopt_long(argc, argv, ":h", longopts, NULL)) != -1)
+    // '+': stop at the command, its options are parsed by the command
+    while ((ch = getopt_long(argc, argv, "+:h", longopts, NULL)) != -1)
         switch (ch) {
             case 'h':
                 usage(binname);
@@ -172,6 +947,8 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    optind = 1;
+
     int res = 0;
     try {
         res = (*cmd)(argc, argv);
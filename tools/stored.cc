@@ -0,0 +1,71 @@
+#include <data.h>
+#include <stored.h>
+
+#include <iostream>
+#include <csignal>
+
+#include <boost/program_options.hpp>
+
+static iris::data::store_server *the_server = nullptr;
+
+static void handle_signal(int) {
+    if (the_server != nullptr) {
+        the_server->stop();
+    }
+}
+
+int main(int argc, char **argv) {
+
+    namespace po = boost::program_options;
+
+    std::string socket_path = iris::data::store_service_path();
+
+    po::options_description opts("IRIS store service");
+    opts.add_options()
+            ("help", "produce help message")
+            ("socket", po::value<std::string>(&socket_path), "unix socket to listen on");
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, opts), vm);
+        po::notify(vm);
+    } catch (const std::exception &e) {
+        std::cerr << "Error while parsing commad line options: " << std::endl;
+        std::cerr << "\t" << e.what() << std::endl;
+        return 1;
+    }
+
+    if (vm.count("help") > 0) {
+        std::cout << opts << std::endl;
+        return 0;
+    }
+
+    try {
+        iris::data::store store = iris::data::store::default_store(false);
+        iris::data::store_server server(store, socket_path);
+
+        // no SA_RESTART, so that poll() is interrupted
+        struct sigaction sa;
+        sa.sa_handler = handle_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = 0;
+
+        the_server = &server;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        signal(SIGPIPE, SIG_IGN);
+
+        std::cerr << "[I] serving store @ " << store.location().path() << std::endl;
+        std::cerr << "[I] listening on " << socket_path << std::endl;
+
+        server.run();
+        the_server = nullptr;
+
+    } catch (const std::exception &e) {
+        std::cerr << "[E] " << e.what() << std::endl;
+        return -1;
+    }
+
+    std::cerr << "[I] bye" << std::endl;
+    return 0;
+}